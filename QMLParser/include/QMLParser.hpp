@@ -1,4 +1,15 @@
 #pragma once
 
+#include "QMLParser/batch.hpp"
+#include "QMLParser/cache.hpp"
+#include "QMLParser/file.hpp"
 #include "QMLParser/lexer.hpp"
-#include "QMLParser/parser.hpp"
\ No newline at end of file
+#include "QMLParser/literal.hpp"
+#include "QMLParser/parallel.hpp"
+#include "QMLParser/parser.hpp"
+#include "QMLParser/readings.hpp"
+#include "QMLParser/recovery.hpp"
+#include "QMLParser/serialize.hpp"
+#include "QMLParser/session.hpp"
+#include "QMLParser/stream.hpp"
+#include "QMLParser/teardown.hpp"
\ No newline at end of file
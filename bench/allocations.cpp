@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "allocations.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<int64_t> allocations{ 0 };
+
+    // What plain `operator new` must align to.
+    constexpr std::size_t plain = alignof(std::max_align_t);
+
+    void* allocate(std::size_t size, std::size_t alignment) noexcept
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        size = size != 0 ? size : 1;
+        if (alignment <= plain) {
+            return std::malloc(size);
+        }
+#ifdef _WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        // aligned_alloc() wants a multiple of the alignment.
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    void release(void* p, std::size_t alignment) noexcept
+    {
+#ifdef _WIN32
+        if (alignment > plain) {
+            _aligned_free(p);
+            return;
+        }
+#else
+        static_cast<void>(alignment);
+#endif
+        std::free(p);
+    }
+
+    void* allocateOrThrow(std::size_t size, std::size_t alignment)
+    {
+        if (void* p = allocate(size, alignment)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+namespace iif_sadaf::talk::QMLParser::bench {
+
+int64_t allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size, plain); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size, plain); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, plain); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, plain); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* p) noexcept { release(p, plain); }
+void operator delete[](void* p) noexcept { release(p, plain); }
+void operator delete(void* p, std::size_t) noexcept { release(p, plain); }
+void operator delete[](void* p, std::size_t) noexcept { release(p, plain); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { release(p, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { release(p, static_cast<std::size_t>(alignment)); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept { release(p, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept { release(p, static_cast<std::size_t>(alignment)); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p, plain); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p, plain); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { release(p, static_cast<std::size_t>(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { release(p, static_cast<std::size_t>(alignment)); }
@@ -0,0 +1,24 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace iif_sadaf::talk::QMLParser::bench {
+
+/**
+ * @brief Counts the allocations made through `operator new` by the whole process.
+ *
+ * Linking allocations.cpp into a benchmark replaces every form of the global `operator new`
+ * and `operator delete`. They live in a translation unit of their own, so the compiler never
+ * sees a replaced `operator delete` inlined next to the allocation it frees.
+ *
+ * @return The number of allocations made so far.
+ */
+int64_t allocation_count();
+
+}
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser::legacy {
+
+/**
+ * @brief The byte-by-byte lexer that predates the table-driven one.
+ *
+ * Kept verbatim as the baseline the benchmarks compare against, and as the reference
+ * `lex()` must agree with token for token.
+ *
+ * @param formula The input string representing a QML formula.
+ * @return A vector of `Token` objects.
+ */
+std::vector<Token> lex(const std::string& formula);
+
+}
@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "legacy_lexer.hpp"
+#include "lexer.hpp"
+
+namespace QMLParser = iif_sadaf::talk::QMLParser;
+
+namespace {
+    // One formula per line. Set QMLPARSER_CORPUS to benchmark another file.
+    std::vector<std::string> loadCorpus()
+    {
+        const char* path = std::getenv("QMLPARSER_CORPUS");
+        std::ifstream file(path != nullptr ? path : QMLPARSER_BENCH_CORPUS, std::ios::binary);
+        std::vector<std::string> formulas;
+        std::string line;
+        while (std::getline(file, line)) {
+            formulas.push_back(line);
+        }
+        return formulas;
+    }
+
+    const std::vector<std::string>& corpus()
+    {
+        static const std::vector<std::string> formulas = loadCorpus();
+        return formulas;
+    }
+
+    int64_t corpusBytes()
+    {
+        int64_t bytes = 0;
+        for (const std::string& formula : corpus()) {
+            bytes += static_cast<int64_t>(formula.size());
+        }
+        return bytes;
+    }
+
+    bool sameTokens(const std::vector<QMLParser::Token>& lhs, const std::vector<QMLParser::Token>& rhs)
+    {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            if (lhs[i].type != rhs[i].type || lhs[i].literal != rhs[i].literal) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Lexer>
+    void runOverCorpus(benchmark::State& state, Lexer lexer)
+    {
+        const std::vector<std::string>& formulas = corpus();
+        for (auto _ : state) {
+            for (const std::string& formula : formulas) {
+                benchmark::DoNotOptimize(lexer(formula));
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * corpusBytes());
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(formulas.size()));
+    }
+
+    void BM_LegacyLex(benchmark::State& state)
+    {
+        runOverCorpus(state, [](const std::string& formula) { return QMLParser::legacy::lex(formula); });
+    }
+
+    void BM_Lex(benchmark::State& state)
+    {
+        runOverCorpus(state, [](const std::string& formula) { return QMLParser::lex(formula); });
+    }
+
+    void BM_LexView(benchmark::State& state)
+    {
+        runOverCorpus(state, [](const std::string& formula) { return QMLParser::lex_view(formula); });
+    }
+
+    void BM_LexerStream(benchmark::State& state)
+    {
+        runOverCorpus(state, [](const std::string& formula) {
+            QMLParser::Lexer lexer(formula);
+            size_t count = 0;
+            while (lexer.next().type != QMLParser::TokenType::EOI) {
+                ++count;
+            }
+            return count;
+        });
+    }
+}
+
+BENCHMARK(BM_LegacyLex);
+BENCHMARK(BM_Lex);
+BENCHMARK(BM_LexView);
+BENCHMARK(BM_LexerStream);
+
+int main(int argc, char** argv)
+{
+    if (corpus().empty()) {
+        std::cerr << "No formulas to benchmark\n";
+        return 1;
+    }
+
+    // The table-driven lexer must reproduce the legacy one exactly, ILLEGAL tokens included.
+    for (const std::string& formula : corpus()) {
+        if (!sameTokens(QMLParser::lex(formula), QMLParser::legacy::lex(formula))) {
+            std::cerr << "lex() disagrees with the legacy lexer on: " << formula << "\n";
+            return 1;
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,465 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "allocations.hpp"
+#include "builder.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "recovery.hpp"
+
+namespace QMLExpression = iif_sadaf::talk::QMLExpression;
+namespace QMLParser = iif_sadaf::talk::QMLParser;
+
+namespace {
+    // One formula per line. Set QMLPARSER_CORPUS to benchmark another file.
+    std::vector<std::string> loadCorpus()
+    {
+        const char* path = std::getenv("QMLPARSER_CORPUS");
+        std::ifstream file(path != nullptr ? path : QMLPARSER_BENCH_CORPUS, std::ios::binary);
+        std::vector<std::string> formulas;
+        std::string line;
+        while (std::getline(file, line)) {
+            formulas.push_back(line);
+        }
+        return formulas;
+    }
+
+    // The formulas of the corpus that parse.
+    const std::vector<std::string>& corpus()
+    {
+        static const std::vector<std::string> formulas = [] {
+            std::vector<std::string> parsed;
+            for (std::string& formula : loadCorpus()) {
+                if (QMLParser::parse(formula).has_value()) {
+                    parsed.push_back(std::move(formula));
+                }
+            }
+            return parsed;
+        }();
+        return formulas;
+    }
+
+    /*
+     * Synthetic formulas, shaped by four knobs:
+     * - depth: how many levels of brackets, each holding the level below;
+     * - width: how many operands each level chains with binary connectives;
+     * - arity: how many arguments each predication has;
+     * - length: how long each identifier is.
+     * The same knobs always give the same formulas, and formulas that only differ in the
+     * length of their identifiers have the same shape.
+     */
+    class Generator
+    {
+    public:
+        Generator(int depth, int width, int arity, int length)
+            : m_Depth(depth), m_Width(width), m_Arity(arity), m_Length(length), m_Shape(static_cast<unsigned>(depth * 10007 + width * 101 + arity)), m_Letters(static_cast<unsigned>(length))
+        {
+        }
+
+        std::string formula()
+        {
+            std::string text;
+            level(text, m_Depth);
+            return text;
+        }
+
+    private:
+        void level(std::string& text, int depth)
+        {
+            static constexpr const char* connectives[] = { " ∧ ", " ∨ ", " → ", " ↔ " };
+            static constexpr const char* prefixes[] = { "", "", "¬", "□", "⋄", "∀x ", "∃y " };
+
+            for (int i = 0; i < m_Width; ++i) {
+                if (i > 0) {
+                    text += connectives[pick(std::size(connectives))];
+                }
+                text += prefixes[pick(std::size(prefixes))];
+                if (depth == 0) {
+                    atom(text);
+                }
+                else {
+                    text += pick(2) == 0 ? '(' : '[';
+                    const char closing = text.back() == '(' ? ')' : ']';
+                    level(text, depth - 1);
+                    text += closing;
+                }
+            }
+        }
+
+        void atom(std::string& text)
+        {
+            if (pick(4) == 0) {
+                term(text);
+                text += pick(2) == 0 ? " = " : " ≠ ";
+                term(text);
+                return;
+            }
+            identifier(text);
+            text += '(';
+            for (int i = 0; i < m_Arity; ++i) {
+                if (i > 0) {
+                    text += ", ";
+                }
+                term(text);
+            }
+            text += ')';
+        }
+
+        void term(std::string& text)
+        {
+            if (pick(2) == 0) {
+                text += pick(2) == 0 ? "x" : "y";
+                return;
+            }
+            identifier(text);
+        }
+
+        void identifier(std::string& text)
+        {
+            static constexpr char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWabcdefghijklmnopqrstuvw";
+            for (int i = 0; i < m_Length; ++i) {
+                text += letters[std::uniform_int_distribution<size_t>(0, std::size(letters) - 2)(m_Letters)];
+            }
+        }
+
+        size_t pick(size_t n)
+        {
+            return std::uniform_int_distribution<size_t>(0, n - 1)(m_Shape);
+        }
+
+        int m_Depth;
+        int m_Width;
+        int m_Arity;
+        int m_Length;
+        // Identifiers are drawn apart, so that their length does not change the shape.
+        std::mt19937 m_Shape;
+        std::mt19937 m_Letters;
+    };
+
+    std::vector<std::string> synthetic(const benchmark::State& state)
+    {
+        Generator generator(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), static_cast<int>(state.range(2)), static_cast<int>(state.range(3)));
+        std::vector<std::string> formulas(64);
+        for (std::string& formula : formulas) {
+            formula = generator.formula();
+        }
+        return formulas;
+    }
+
+    // Each formula of the corpus, wrapped if need be so that it parses from `rule`.
+    std::vector<std::string> corpusFor(QMLParser::Rule rule)
+    {
+        const auto entryPoint = QMLParser::Parser::entryPointFor(rule);
+        std::vector<std::string> formulas;
+        for (const std::string& formula : corpus()) {
+            for (const std::string& candidate : { formula, "(" + formula + ")", "¬(" + formula + ")", "∀x (" + formula + ")" }) {
+                if (QMLParser::parse(candidate, entryPoint).has_value()) {
+                    formulas.push_back(candidate);
+                    break;
+                }
+            }
+        }
+        return formulas;
+    }
+
+    // Runs `work` over every formula each iteration, and reports bytes, formulas and
+    // allocations per formula.
+    template<typename Input, typename Work>
+    void runOver(benchmark::State& state, const std::vector<Input>& inputs, int64_t bytes, Work work)
+    {
+        if (inputs.empty()) {
+            state.SkipWithError("No formulas to benchmark");
+            return;
+        }
+
+        const int64_t before = QMLParser::bench::allocation_count();
+        for (auto _ : state) {
+            for (const Input& input : inputs) {
+                benchmark::DoNotOptimize(work(input));
+            }
+        }
+        const int64_t allocated = QMLParser::bench::allocation_count() - before;
+
+        const int64_t formulas = state.iterations() * static_cast<int64_t>(inputs.size());
+        state.SetBytesProcessed(state.iterations() * bytes);
+        state.SetItemsProcessed(formulas);
+        state.counters["allocs/formula"] = static_cast<double>(allocated) / static_cast<double>(formulas);
+    }
+
+    // Every copy made of a node handle or a term by the parser, counted by CountingBuilder.
+    // Copying a node handle is a reference count increment, and copying a term a string copy.
+    std::atomic<int64_t> copies{ 0 };
+
+    template<typename T>
+    struct Counted {
+        T value;
+
+        Counted(T value) : value(std::move(value)) {}
+        Counted(const Counted& other) : value(other.value) { copies.fetch_add(1, std::memory_order_relaxed); }
+        Counted(Counted&&) noexcept = default;
+
+        Counted& operator=(const Counted& other)
+        {
+            value = other.value;
+            copies.fetch_add(1, std::memory_order_relaxed);
+            return *this;
+        }
+
+        Counted& operator=(Counted&&) noexcept = default;
+    };
+
+    // Builds what ExpressionBuilder builds, out of values that count their copies.
+    struct CountingBuilder {
+        using Value = Counted<QMLExpression::Expression>;
+        using TermValue = Counted<QMLExpression::Term>;
+        using Arguments = std::vector<QMLExpression::Term>;
+
+        TermValue term(std::string_view literal, QMLParser::TokenType type) const { return inner.term(literal, type); }
+        Arguments arguments(size_t count) const { return inner.arguments(count); }
+        void argument(Arguments& arguments, TermValue term) const { inner.argument(arguments, std::move(term.value)); }
+        Value unary(QMLExpression::Operator op, Value scope) const { return inner.unary(op, std::move(scope.value)); }
+        Value binary(QMLExpression::Operator op, Value lhs, Value rhs) const { return inner.binary(op, std::move(lhs.value), std::move(rhs.value)); }
+        Value quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const { return inner.quantification(quantifier, std::move(variable.value), std::move(scope.value)); }
+        Value identity(TermValue lhs, TermValue rhs) const { return inner.identity(std::move(lhs.value), std::move(rhs.value)); }
+        Value predication(std::string_view predicate, Arguments arguments) const { return inner.predication(predicate, std::move(arguments)); }
+
+        QMLParser::ExpressionBuilder inner;
+    };
+
+    using CountingParser = QMLParser::BasicParser<QMLParser::Parser::MappingFunction, QMLParser::Rule::DYNAMIC, std::string, CountingBuilder>;
+
+    int64_t totalBytes(const std::vector<std::string>& formulas)
+    {
+        int64_t bytes = 0;
+        for (const std::string& formula : formulas) {
+            bytes += static_cast<int64_t>(formula.size());
+        }
+        return bytes;
+    }
+
+    void lexOver(benchmark::State& state, const std::vector<std::string>& formulas)
+    {
+        runOver(state, formulas, totalBytes(formulas), [](const std::string& formula) { return QMLParser::lex(formula); });
+    }
+
+    // Lexes every formula into the same list of type `Tokens`, as a parser kept around does.
+    template<typename Tokens>
+    void lexIntoOver(benchmark::State& state, const std::vector<std::string>& formulas)
+    {
+        Tokens tokens;
+        runOver(state, formulas, totalBytes(formulas), [&](const std::string& formula) {
+            QMLParser::lex(formula, tokens);
+            return tokens.size();
+        });
+    }
+
+    // Only the parser is measured: the formulas are lexed up front, and not copied.
+    void parseOver(benchmark::State& state, const std::vector<std::string>& formulas, QMLParser::Rule rule)
+    {
+        std::vector<QMLParser::TokenBuffer> tokens(formulas.size());
+        for (size_t i = 0; i < formulas.size(); ++i) {
+            QMLParser::lex(formulas[i], tokens[i]);
+        }
+
+        const auto entryPoint = QMLParser::Parser::entryPointFor(rule);
+        runOver(state, tokens, totalBytes(formulas), [&](const QMLParser::TokenBuffer& formula) {
+            return QMLParser::Parser(formula, &QMLParser::mapToAlethicOperator).parse(entryPoint);
+        });
+    }
+
+    // As parseOver(), from the default entry rule, counting the copies the parser makes.
+    void copiesOver(benchmark::State& state, const std::vector<std::string>& formulas)
+    {
+        std::vector<QMLParser::TokenBuffer> tokens(formulas.size());
+        for (size_t i = 0; i < formulas.size(); ++i) {
+            QMLParser::lex(formulas[i], tokens[i]);
+        }
+
+        const int64_t before = copies.load(std::memory_order_relaxed);
+        runOver(state, tokens, totalBytes(formulas), [](const QMLParser::TokenBuffer& formula) {
+            return CountingParser(formula, &QMLParser::mapToAlethicOperator).parse();
+        });
+        const int64_t copied = copies.load(std::memory_order_relaxed) - before;
+
+        const int64_t parsed = state.iterations() * static_cast<int64_t>(formulas.size());
+        state.counters["copies/formula"] = parsed != 0 ? static_cast<double>(copied) / static_cast<double>(parsed) : 0.0;
+    }
+
+    void endToEndOver(benchmark::State& state, const std::vector<std::string>& formulas)
+    {
+        runOver(state, formulas, totalBytes(formulas), [](const std::string& formula) { return QMLParser::parse(formula); });
+    }
+
+    // As endToEndOver(), recording the source span of every node into a reused list.
+    void spansOver(benchmark::State& state, const std::vector<std::string>& formulas)
+    {
+        std::vector<QMLParser::SourceSpan> spans;
+        runOver(state, formulas, totalBytes(formulas), [&](const std::string& formula) { return QMLParser::parse(formula, spans); });
+    }
+
+    void recoverOver(benchmark::State& state, const std::vector<std::string>& formulas)
+    {
+        runOver(state, formulas, totalBytes(formulas), [](const std::string& formula) { return QMLParser::parse_recovering(formula); });
+    }
+
+    // The corpus with two errors in each formula: an operand missing inside brackets, and another at the end.
+    const std::vector<std::string>& brokenCorpus()
+    {
+        static const std::vector<std::string> formulas = [] {
+            std::vector<std::string> broken;
+            for (const std::string& formula : corpus()) {
+                broken.push_back("(" + formula + " ∧ ) ∨ " + formula + " ↔");
+            }
+            return broken;
+        }();
+        return formulas;
+    }
+
+    void BM_LexCorpus(benchmark::State& state)
+    {
+        lexOver(state, corpus());
+    }
+
+    void BM_LexIntoTokensCorpus(benchmark::State& state)
+    {
+        lexIntoOver<std::vector<QMLParser::Token>>(state, corpus());
+    }
+
+    void BM_LexIntoBufferCorpus(benchmark::State& state)
+    {
+        lexIntoOver<QMLParser::TokenBuffer>(state, corpus());
+    }
+
+    void BM_ParseCorpus(benchmark::State& state, QMLParser::Rule rule)
+    {
+        parseOver(state, corpusFor(rule), rule);
+    }
+
+    void BM_CopiesCorpus(benchmark::State& state)
+    {
+        copiesOver(state, corpus());
+    }
+
+    void BM_EndToEndCorpus(benchmark::State& state)
+    {
+        endToEndOver(state, corpus());
+    }
+
+    void BM_SpansCorpus(benchmark::State& state)
+    {
+        spansOver(state, corpus());
+    }
+
+    void BM_RecoverCorpus(benchmark::State& state)
+    {
+        recoverOver(state, corpus());
+    }
+
+    void BM_RecoverBrokenCorpus(benchmark::State& state)
+    {
+        recoverOver(state, brokenCorpus());
+    }
+
+    void BM_LexSynthetic(benchmark::State& state)
+    {
+        lexOver(state, synthetic(state));
+    }
+
+    void BM_ParseSynthetic(benchmark::State& state)
+    {
+        parseOver(state, synthetic(state), QMLParser::Rule::EQUIVALENCE);
+    }
+
+    void BM_CopiesSynthetic(benchmark::State& state)
+    {
+        copiesOver(state, synthetic(state));
+    }
+
+    void BM_EndToEndSynthetic(benchmark::State& state)
+    {
+        endToEndOver(state, synthetic(state));
+    }
+
+    // Varies one knob at a time around a formula of moderate size.
+    void shapes(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({ "depth", "width", "arity", "length" });
+        for (const int depth : { 0, 1, 2, 4, 8 }) {
+            benchmark->Args({ depth, 2, 2, 4 });
+        }
+        for (const int width : { 8, 32, 128 }) {
+            benchmark->Args({ 0, width, 2, 4 });
+        }
+        for (const int arity : { 1, 8, 32 }) {
+            benchmark->Args({ 1, 2, arity, 4 });
+        }
+        for (const int length : { 1, 16, 64 }) {
+            benchmark->Args({ 1, 2, 2, length });
+        }
+    }
+}
+
+BENCHMARK(BM_LexCorpus);
+BENCHMARK(BM_LexIntoTokensCorpus);
+BENCHMARK(BM_LexIntoBufferCorpus);
+BENCHMARK_CAPTURE(BM_ParseCorpus, equivalence, QMLParser::Rule::EQUIVALENCE);
+BENCHMARK_CAPTURE(BM_ParseCorpus, implication, QMLParser::Rule::IMPLICATION);
+BENCHMARK_CAPTURE(BM_ParseCorpus, conjunction_disjunction, QMLParser::Rule::CONJUNCTION_DISJUNCTION);
+BENCHMARK_CAPTURE(BM_ParseCorpus, clause, QMLParser::Rule::CLAUSE);
+BENCHMARK_CAPTURE(BM_ParseCorpus, quantificational, QMLParser::Rule::QUANTIFICATIONAL);
+BENCHMARK_CAPTURE(BM_ParseCorpus, unary, QMLParser::Rule::UNARY);
+BENCHMARK_CAPTURE(BM_ParseCorpus, atomic, QMLParser::Rule::ATOMIC);
+BENCHMARK_CAPTURE(BM_ParseCorpus, predication, QMLParser::Rule::PREDICATION);
+BENCHMARK_CAPTURE(BM_ParseCorpus, identity, QMLParser::Rule::IDENTITY);
+BENCHMARK_CAPTURE(BM_ParseCorpus, inequality, QMLParser::Rule::INEQUALITY);
+BENCHMARK(BM_CopiesCorpus);
+BENCHMARK(BM_EndToEndCorpus);
+BENCHMARK(BM_SpansCorpus);
+BENCHMARK(BM_RecoverCorpus);
+BENCHMARK(BM_RecoverBrokenCorpus);
+BENCHMARK(BM_LexSynthetic)->Apply(shapes);
+BENCHMARK(BM_ParseSynthetic)->Apply(shapes);
+BENCHMARK(BM_CopiesSynthetic)->Apply(shapes);
+BENCHMARK(BM_EndToEndSynthetic)->Apply(shapes);
+
+int main(int argc, char** argv)
+{
+    if (corpus().empty()) {
+        std::cerr << "No formulas to benchmark\n";
+        return 1;
+    }
+
+    // The generated formulas must all be well formed, or the parser benchmarks measure failures.
+    for (const int depth : { 0, 3 }) {
+        Generator generator(depth, 3, 3, 5);
+        for (int i = 0; i < 100; ++i) {
+            const std::string formula = generator.formula();
+            if (const auto result = QMLParser::parse(formula); !result.has_value()) {
+                std::cerr << "Generated formula does not parse: " << formula << " (" << result.error() << ")\n";
+                return 1;
+            }
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "lexer.hpp"
+#include "scan.hpp"
+
+namespace QMLParser = iif_sadaf::talk::QMLParser;
+
+namespace {
+    constexpr std::string_view identifier_alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_.";
+
+    std::string identifier(size_t length, std::mt19937& rng)
+    {
+        std::uniform_int_distribution<size_t> pick(0, identifier_alphabet.size() - 1);
+        std::string result;
+        for (size_t i = 0; i < length; ++i) {
+            result.push_back(identifier_alphabet[pick(rng)]);
+        }
+        return result;
+    }
+
+    // Predications over long names, e.g. "Walk.Fast_1(John, Mary)", joined by conjunctions.
+    std::string formulaWithNames(size_t length)
+    {
+        std::mt19937 rng(static_cast<unsigned>(length));
+        std::string formula;
+        for (int i = 0; i < 8; ++i) {
+            if (i != 0) {
+                formula += " \xE2\x88\xA7 ";
+            }
+            formula += "P" + identifier(length, rng) + "(c" + identifier(length, rng) + ", d" + identifier(length, rng) + ")";
+        }
+        return formula;
+    }
+
+    // Runs of the given length separated by a single '(' so every scan stops inside the buffer.
+    std::string runs(size_t length, char filler)
+    {
+        std::mt19937 rng(static_cast<unsigned>(length));
+        std::string text;
+        while (text.size() < 4096) {
+            text += filler == ' ' ? std::string(length, ' ') : identifier(length, rng);
+            text += '(';
+        }
+        return text;
+    }
+
+    template<size_t (*Scan)(std::string_view, size_t)>
+    void scanAll(benchmark::State& state, char filler)
+    {
+        const std::string text = runs(static_cast<size_t>(state.range(0)), filler);
+        for (auto _ : state) {
+            size_t pos = 0;
+            while (pos < text.size()) {
+                pos = Scan(text, pos) + 1;
+            }
+            benchmark::DoNotOptimize(pos);
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    }
+
+    void BM_IdentifierScalar(benchmark::State& state) { scanAll<&QMLParser::detail::scanIdentifierScalar>(state, 'a'); }
+    void BM_IdentifierSimd(benchmark::State& state) { scanAll<&QMLParser::detail::scanIdentifier>(state, 'a'); }
+    void BM_SpacesScalar(benchmark::State& state) { scanAll<&QMLParser::detail::scanSpacesScalar>(state, ' '); }
+    void BM_SpacesSimd(benchmark::State& state) { scanAll<&QMLParser::detail::scanSpaces>(state, ' '); }
+
+    void BM_LexViewLongNames(benchmark::State& state)
+    {
+        const std::string formula = formulaWithNames(static_cast<size_t>(state.range(0)));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(QMLParser::lex_view(formula));
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(formula.size()));
+    }
+
+    // Every byte value at every offset of a buffer longer than two vectors.
+    bool scannersAgree()
+    {
+        std::mt19937 rng(42);
+        for (int c = 0; c < 256; ++c) {
+            for (size_t at = 0; at < 80; ++at) {
+                std::string text = identifier(80, rng);
+                std::string spaces(80, ' ');
+                text[at] = static_cast<char>(c);
+                spaces[at] = static_cast<char>(c);
+                for (size_t from = 0; from <= text.size(); from += 7) {
+                    if (QMLParser::detail::scanIdentifier(text, from) != QMLParser::detail::scanIdentifierScalar(text, from)
+                        || QMLParser::detail::scanSpaces(spaces, from) != QMLParser::detail::scanSpacesScalar(spaces, from)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
+
+BENCHMARK(BM_IdentifierScalar)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(BM_IdentifierSimd)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(BM_SpacesScalar)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(BM_SpacesSimd)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(BM_LexViewLongNames)->Arg(4)->Arg(16)->Arg(64);
+
+int main(int argc, char** argv)
+{
+    if (!scannersAgree()) {
+        std::cerr << "The vectorized scanners disagree with the scalar ones\n";
+        return 1;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
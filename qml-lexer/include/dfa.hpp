@@ -0,0 +1,378 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "token.hpp"
+
+/*
+ * The DFA the lexer runs, as constexpr tables and functions, so that formulas can also be
+ * lexed at compile time (see literal.hpp). What a step produces goes to a sink, and the
+ * runs of identifier bytes and spaces are skipped by a scanner, which the run-time lexer
+ * replaces with the vector scanners of scan.hpp.
+ */
+namespace iif_sadaf::talk::QMLParser::detail {
+
+constexpr bool isIdentifierByte(uint8_t c)
+{
+    return c == '_'
+        || c == '.'
+        || (c >= '0' && c <= '9')
+        || (c >= 'A' && c <= 'Z')
+        || (c >= 'a' && c <= 'z')
+    ;
+}
+
+/*
+ * Variables are a single x, y or z, optionally followed by digits, possibly after one
+ * underscore (see the README). They are recognized by a four-state DFA over four
+ * character classes, plus a dead state; both of its tables are built at compile time.
+ */
+enum VariableClass : uint8_t {
+    XYZ, DIGIT, UNDERSCORE, NOT_VARIABLE_SYMBOL,
+    VARIABLE_CLASS_COUNT
+};
+
+constexpr std::array<VariableClass, 256> makeVariableClassTable()
+{
+    std::array<VariableClass, 256> table{};
+    table.fill(NOT_VARIABLE_SYMBOL);
+    table['x'] = XYZ;
+    table['y'] = XYZ;
+    table['z'] = XYZ;
+    table['_'] = UNDERSCORE;
+    for (uint8_t c = '0'; c <= '9'; ++c) {
+        table[c] = DIGIT;
+    }
+    return table;
+}
+
+inline constexpr std::array<VariableClass, 256> variable_class = makeVariableClassTable();
+
+inline constexpr uint8_t dead_state = 4;
+
+inline constexpr uint8_t variable_dfa[5][VARIABLE_CLASS_COUNT] = {
+    //  x,y,z        0-9   _           other
+    { 1,          dead_state, dead_state, dead_state }, // 0: initial
+    { dead_state, 3,          2,          dead_state }, // 1: x, y or z
+    { dead_state, 3,          dead_state, dead_state }, // 2: x_, y_ or z_
+    { dead_state, 3,          dead_state, dead_state }, // 3: followed by digits
+    { dead_state, dead_state, dead_state, dead_state }, // 4: dead
+};
+
+inline constexpr uint8_t final_states[2] = {1, 3};
+inline constexpr uint8_t initial_state = 0;
+
+constexpr bool isVariable(std::string_view token)
+{
+    uint8_t state = initial_state;
+    for (const char c : token) {
+        state = variable_dfa[state][variable_class[static_cast<uint8_t>(c)]];
+        if (state == dead_state) {
+            return false;
+        }
+    }
+    return state == final_states[0] || state == final_states[1];
+}
+
+static_assert(isVariable("x") && isVariable("y_1") && isVariable("z2") && isVariable("x_10"));
+static_assert(!isVariable("") && !isVariable("x_") && !isVariable("y__2") && !isVariable("zz2") && !isVariable("John"));
+
+/*
+ * The lexer is a DFA over byte classes. Every input byte is mapped to its class through
+ * a 256-entry table, and the pair (state, class) selects a single entry of a flat
+ * transition matrix holding the next state and the action to perform. States track the
+ * prefix of a multi-byte operator read so far (see the symbol table in the README).
+ */
+
+enum ByteClass : uint8_t {
+    SPACE, IDENT, OTHER,
+    LPAREN, RPAREN, LBRACKET, RBRACKET, COMMA, EQUALS,
+    LEAD_C2, LEAD_E2,
+    CONT_80, CONT_83, CONT_84, CONT_86, CONT_88, CONT_89, CONT_8B,
+    CONT_92, CONT_94, CONT_96, CONT_A0, CONT_A1, CONT_A7, CONT_A8, CONT_AC,
+    CLASS_COUNT
+};
+
+enum State : uint8_t {
+    START, SEEN_C2, SEEN_E2, SEEN_E2_86, SEEN_E2_88, SEEN_E2_89, SEEN_E2_8B, SEEN_E2_96,
+    STATE_COUNT
+};
+
+enum class Action : uint8_t {
+    SKIP,           // flush pending tokens
+    EMIT,           // flush pending tokens, then emit the byte as a token
+    BEGIN_OP,       // flush pending tokens, then start an operator
+    EXTEND_OP,      // add the byte to the pending operator
+    COMPLETE_OP,    // add the byte to the pending operator and emit it
+    DROP,           // emit the pending operator as ILLEGAL and discard the byte
+    APPEND,         // add the byte to the pending identifier
+    CLOSE_APPEND,   // emit the pending operator as ILLEGAL, then add the byte to the pending identifier
+    HOIST,          // emit the byte as an ILLEGAL token, leaving pending tokens untouched
+};
+
+struct Transition {
+    State next;
+    Action action;
+    TokenType type;
+};
+
+using ClassTable = std::array<ByteClass, 256>;
+using TransitionTable = std::array<Transition, static_cast<size_t>(STATE_COUNT) * CLASS_COUNT>;
+
+constexpr size_t transitionIndex(State state, ByteClass cls)
+{
+    return static_cast<size_t>(state) * CLASS_COUNT + cls;
+}
+
+constexpr ClassTable makeClassTable()
+{
+    ClassTable table{};
+    for (size_t c = 0; c < table.size(); ++c) {
+        table[c] = isIdentifierByte(static_cast<uint8_t>(c)) ? IDENT : OTHER;
+    }
+    table[' '] = SPACE;
+    table['('] = LPAREN;
+    table[')'] = RPAREN;
+    table['['] = LBRACKET;
+    table[']'] = RBRACKET;
+    table[','] = COMMA;
+    table['='] = EQUALS;
+    table[0xC2] = LEAD_C2;
+    table[0xE2] = LEAD_E2;
+    table[0x80] = CONT_80;
+    table[0x83] = CONT_83;
+    table[0x84] = CONT_84;
+    table[0x86] = CONT_86;
+    table[0x88] = CONT_88;
+    table[0x89] = CONT_89;
+    table[0x8B] = CONT_8B;
+    table[0x92] = CONT_92;
+    table[0x94] = CONT_94;
+    table[0x96] = CONT_96;
+    table[0xA0] = CONT_A0;
+    table[0xA1] = CONT_A1;
+    table[0xA7] = CONT_A7;
+    table[0xA8] = CONT_A8;
+    table[0xAC] = CONT_AC;
+    return table;
+}
+
+/*
+ * Two matrices share the same operator transitions and differ in how they treat bytes
+ * that do not fit the pending token. The ordered one (used by lex_view) keeps every
+ * token a contiguous slice of the input; the other one reproduces the historical
+ * behaviour of lex(), which lets identifier bytes accumulate across a pending operator,
+ * hoists unexpected bytes out of pending tokens and drops rejected continuation bytes.
+ */
+constexpr TransitionTable makeTransitionTable(bool ordered)
+{
+    TransitionTable table{};
+    const auto set = [&](State from, ByteClass cls, Transition transition) -> void {
+        table[transitionIndex(from, cls)] = transition;
+    };
+
+    for (uint8_t s = 0; s < STATE_COUNT; ++s) {
+        const State from = static_cast<State>(s);
+        set(from, SPACE, { START, Action::SKIP, TokenType::NIL });
+        set(from, LPAREN, { START, Action::EMIT, TokenType::LPAREN });
+        set(from, RPAREN, { START, Action::EMIT, TokenType::RPAREN });
+        set(from, LBRACKET, { START, Action::EMIT, TokenType::LBRACKET });
+        set(from, RBRACKET, { START, Action::EMIT, TokenType::RBRACKET });
+        set(from, COMMA, { START, Action::EMIT, TokenType::COMMA });
+        set(from, EQUALS, { START, Action::EMIT, TokenType::ID });
+        set(from, LEAD_C2, { SEEN_C2, Action::BEGIN_OP, TokenType::NIL });
+        set(from, LEAD_E2, { SEEN_E2, Action::BEGIN_OP, TokenType::NIL });
+        set(from, IDENT, ordered ? Transition{ START, Action::CLOSE_APPEND, TokenType::NIL }
+                                 : Transition{ from, Action::APPEND, TokenType::NIL });
+        set(from, OTHER, ordered ? Transition{ START, Action::EMIT, TokenType::ILLEGAL }
+                                 : Transition{ from, Action::HOIST, TokenType::ILLEGAL });
+        for (uint8_t cls = CONT_80; cls <= CONT_AC; ++cls) {
+            set(from, static_cast<ByteClass>(cls), ordered ? Transition{ START, Action::EMIT, TokenType::ILLEGAL }
+                                                           : Transition{ START, Action::DROP, TokenType::NIL });
+        }
+    }
+
+    set(SEEN_C2, CONT_AC, { START, Action::COMPLETE_OP, TokenType::NOT });
+
+    set(SEEN_E2, CONT_86, { SEEN_E2_86, Action::EXTEND_OP, TokenType::NIL });
+    set(SEEN_E2, CONT_88, { SEEN_E2_88, Action::EXTEND_OP, TokenType::NIL });
+    set(SEEN_E2, CONT_89, { SEEN_E2_89, Action::EXTEND_OP, TokenType::NIL });
+    set(SEEN_E2, CONT_8B, { SEEN_E2_8B, Action::EXTEND_OP, TokenType::NIL });
+    set(SEEN_E2, CONT_96, { SEEN_E2_96, Action::EXTEND_OP, TokenType::NIL });
+
+    set(SEEN_E2_86, CONT_92, { START, Action::COMPLETE_OP, TokenType::IF });
+    set(SEEN_E2_86, CONT_94, { START, Action::COMPLETE_OP, TokenType::EQ });
+
+    set(SEEN_E2_88, CONT_80, { START, Action::COMPLETE_OP, TokenType::FORALL });
+    set(SEEN_E2_88, CONT_83, { START, Action::COMPLETE_OP, TokenType::EXISTS });
+    set(SEEN_E2_88, CONT_84, { START, Action::COMPLETE_OP, TokenType::NOT_EXISTS });
+    set(SEEN_E2_88, CONT_A7, { START, Action::COMPLETE_OP, TokenType::AND });
+    set(SEEN_E2_88, CONT_A8, { START, Action::COMPLETE_OP, TokenType::OR });
+
+    set(SEEN_E2_89, CONT_A0, { START, Action::COMPLETE_OP, TokenType::NEQ });
+    set(SEEN_E2_8B, CONT_84, { START, Action::COMPLETE_OP, TokenType::POS });
+    set(SEEN_E2_96, CONT_A1, { START, Action::COMPLETE_OP, TokenType::NEC });
+
+    return table;
+}
+
+inline constexpr ClassTable byte_class = makeClassTable();
+inline constexpr TransitionTable ordered_transitions = makeTransitionTable(true);
+inline constexpr TransitionTable legacy_transitions = makeTransitionTable(false);
+
+// The bytes read so far in each state; complete operators are spelled by fixed_spelling().
+// Tokens built by lex() take their literal from here, because the legacy transitions
+// allow identifier bytes to interleave with the bytes of a pending operator.
+inline constexpr std::array<std::string_view, STATE_COUNT> prefix_spelling = {
+    "", "\xC2", "\xE2", "\xE2\x86", "\xE2\x88", "\xE2\x89", "\xE2\x8B", "\xE2\x96"
+};
+
+// Skips runs one byte at a time; usable at compile time.
+struct ScalarScanner {
+    static constexpr size_t identifier(std::string_view text, size_t pos)
+    {
+        while (pos < text.size() && isIdentifierByte(static_cast<uint8_t>(text[pos]))) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    static constexpr size_t spaces(std::string_view text, size_t pos)
+    {
+        while (pos < text.size() && text[pos] == ' ') {
+            ++pos;
+        }
+        return pos;
+    }
+};
+
+/*
+ * The DFA state carried between bytes: the current state and, while an operator is
+ * pending, the position of its first byte.
+ */
+struct Cursor {
+    State state = START;
+    size_t operator_begin = 0;
+};
+
+/*
+ * Feeds the byte at `i` to the DFA and returns the position of the next byte to feed.
+ * With the ordered transitions, operator literals are sliced from the input; otherwise
+ * the canonical spellings above are used.
+ *
+ * Identifier bytes leave the state unchanged, and a space after a space does nothing,
+ * so both kinds of runs are consumed in one step by the functions of `Scanner`. A step
+ * emits at most two tokens: the pending identifier or operator, and the current one.
+ *
+ * A sink that wants to know where operators and punctuation come from may have
+ * `locate(begin, end)`, which is called with their bytes before each is emitted;
+ * identifiers are located by the calls to `append()`.
+ */
+template<bool Ordered, typename Scanner, typename Sink>
+constexpr size_t step(std::string_view formula, size_t i, Cursor& cursor, Sink& sink)
+{
+    const TransitionTable& transitions = Ordered ? ordered_transitions : legacy_transitions;
+
+    const auto operatorLiteral = [&](size_t end, State prefix, TokenType type) -> std::string_view {
+        if constexpr (Ordered) {
+            return formula.substr(cursor.operator_begin, end - cursor.operator_begin);
+        }
+        else {
+            return type == TokenType::ILLEGAL ? prefix_spelling[prefix] : fixed_spelling(type);
+        }
+    };
+    const auto locate = [&](size_t begin, size_t end) -> void {
+        if constexpr (requires { sink.locate(begin, end); }) {
+            sink.locate(begin, end);
+        }
+    };
+    const auto flushOp = [&](size_t end) -> void {
+        if (cursor.state != START) {
+            locate(cursor.operator_begin, end);
+            sink.emit(operatorLiteral(end, cursor.state, TokenType::ILLEGAL), TokenType::ILLEGAL);
+        }
+    };
+
+    const Transition& transition = transitions[transitionIndex(cursor.state, byte_class[static_cast<uint8_t>(formula[i])])];
+    size_t next = i + 1;
+
+    switch (transition.action) {
+    case Action::SKIP:
+        sink.flushIdentifier();
+        flushOp(i);
+        next = Scanner::spaces(formula, i + 1);
+        break;
+    case Action::EMIT:
+        sink.flushIdentifier();
+        flushOp(i);
+        locate(i, i + 1);
+        sink.emit(formula.substr(i, 1), transition.type);
+        break;
+    case Action::BEGIN_OP:
+        sink.flushIdentifier();
+        flushOp(i);
+        cursor.operator_begin = i;
+        break;
+    case Action::EXTEND_OP:
+        break;
+    case Action::COMPLETE_OP:
+        locate(cursor.operator_begin, i + 1);
+        sink.emit(operatorLiteral(i + 1, cursor.state, transition.type), transition.type);
+        break;
+    case Action::DROP:
+        flushOp(i);
+        break;
+    case Action::APPEND:
+        next = Scanner::identifier(formula, i + 1);
+        sink.append(formula, i, next - i);
+        break;
+    case Action::CLOSE_APPEND:
+        flushOp(i);
+        next = Scanner::identifier(formula, i + 1);
+        sink.append(formula, i, next - i);
+        break;
+    case Action::HOIST:
+        locate(i, i + 1);
+        sink.emit(formula.substr(i, 1), TokenType::ILLEGAL);
+        break;
+    }
+
+    cursor.state = transition.next;
+    return next;
+}
+
+// Emits whatever is still pending once the whole input has been fed.
+template<bool Ordered, typename Sink>
+constexpr void finish(std::string_view formula, Cursor& cursor, Sink& sink)
+{
+    sink.flushIdentifier();
+    if (cursor.state != START) {
+        const std::string_view literal = Ordered ? formula.substr(cursor.operator_begin) : prefix_spelling[cursor.state];
+        if constexpr (requires { sink.locate(cursor.operator_begin, formula.size()); }) {
+            sink.locate(cursor.operator_begin, formula.size());
+        }
+        sink.emit(literal, TokenType::ILLEGAL);
+    }
+    cursor.state = START;
+}
+
+template<bool Ordered, typename Scanner, typename Sink>
+constexpr void run(std::string_view formula, Sink& sink)
+{
+    Cursor cursor;
+    for (size_t i = 0; i < formula.size(); ) {
+        i = step<Ordered, Scanner>(formula, i, cursor, sink);
+    }
+    finish<Ordered>(formula, cursor, sink);
+}
+
+}
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class Generator
+ * @brief A lazily computed sequence of values, produced by a coroutine.
+ *
+ * The subset of `std::generator` the library needs, for standard libraries that lack
+ * `<generator>`. The coroutine runs only while the sequence is being iterated, up to its
+ * next `co_yield`, so a consumer that stops early never pays for the rest. A generator is
+ * an input range: it can be iterated only once, and composes with the standard views.
+ *
+ * Dereferencing the iterator gives the value last yielded, which may be moved from. An
+ * exception thrown by the coroutine is rethrown by the iterator.
+ *
+ * @tparam T The type of the values produced.
+ */
+template <typename T>
+class Generator : public std::ranges::view_interface<Generator<T>>
+{
+public:
+    class promise_type
+    {
+    public:
+        Generator get_return_object()
+        {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+
+        // The operand of `co_yield` lives until the coroutine resumes, so it is not copied.
+        std::suspend_always yield_value(T&& value) noexcept
+        {
+            m_Value = std::addressof(value);
+            return {};
+        }
+
+        std::suspend_always yield_value(const T& value) requires std::copy_constructible<T>
+        {
+            m_Copy.emplace(value);
+            m_Value = std::addressof(*m_Copy);
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() { m_Exception = std::current_exception(); }
+
+        // Forbids `co_await` inside a generator.
+        template <typename U>
+        std::suspend_never await_transform(U&&) = delete;
+
+        T& value() const noexcept { return *m_Value; }
+
+        void rethrow() const
+        {
+            if (m_Exception) {
+                std::rethrow_exception(m_Exception);
+            }
+        }
+
+    private:
+        T* m_Value = nullptr;
+        std::optional<T> m_Copy;
+        std::exception_ptr m_Exception;
+    };
+
+    class iterator
+    {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = std::remove_cvref_t<T>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        T& operator*() const noexcept { return m_Coroutine.promise().value(); }
+
+        iterator& operator++()
+        {
+            advance(m_Coroutine);
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept
+        {
+            return !it.m_Coroutine || it.m_Coroutine.done();
+        }
+
+    private:
+        friend class Generator;
+
+        explicit iterator(std::coroutine_handle<promise_type> coroutine) : m_Coroutine(coroutine) {}
+
+        std::coroutine_handle<promise_type> m_Coroutine = nullptr;
+    };
+
+    Generator() = default;
+
+    Generator(Generator&& other) noexcept : m_Coroutine(std::exchange(other.m_Coroutine, nullptr)) {}
+
+    Generator& operator=(Generator&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            m_Coroutine = std::exchange(other.m_Coroutine, nullptr);
+        }
+        return *this;
+    }
+
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    ~Generator() { destroy(); }
+
+    /**
+     * @brief Runs the coroutine up to its first value.
+     *
+     * May only be called once.
+     */
+    iterator begin()
+    {
+        if (m_Coroutine) {
+            advance(m_Coroutine);
+        }
+        return iterator(m_Coroutine);
+    }
+
+    std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> coroutine) : m_Coroutine(coroutine) {}
+
+    static void advance(std::coroutine_handle<promise_type> coroutine)
+    {
+        coroutine.resume();
+        if (coroutine.done()) {
+            coroutine.promise().rethrow();
+        }
+    }
+
+    void destroy()
+    {
+        if (m_Coroutine) {
+            m_Coroutine.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> m_Coroutine = nullptr;
+};
+
+}
@@ -6,9 +6,15 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "generator.hpp"
+#include "symbols.hpp"
 #include "token.hpp"
 
 namespace iif_sadaf::talk::QMLParser {
@@ -21,4 +27,134 @@ namespace iif_sadaf::talk::QMLParser {
  */
 std::vector<Token> lex(const std::string& formula);
 
+/**
+ * @brief Tokenizes a given QML formula into an existing list.
+ *
+ * Produces the same tokens as `lex()`, but replaces the contents of `tokens` instead of
+ * returning a new list. The list keeps its capacity, and so do the literals of the tokens
+ * it already held, so lexing formula after formula into the same list stops allocating
+ * once it has grown large enough.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param tokens The list to fill with `Token` objects.
+ */
+void lex(std::string_view formula, std::vector<Token>& tokens);
+
+/**
+ * @brief Tokenizes a given QML formula into a compact token buffer.
+ *
+ * Produces the same tokens as `lex()`, but replaces the contents of `tokens`, which copies
+ * only the literals of identifiers, variables and illegal tokens. As with a list of
+ * `Token`, lexing formula after formula into the same buffer stops allocating.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param tokens The buffer to fill.
+ */
+void lex(std::string_view formula, TokenBuffer& tokens);
+
+/**
+ * @brief Tokenizes a given QML formula into a compact token buffer, recording where each token is.
+ *
+ * Fills `tokens` with the tokens of `lex()`, and `spans` with the bytes of `formula` each
+ * of them was lexed from, one span per token; the span of `EOI` is empty, at the end of the
+ * formula. The contents of both are replaced. Where `lex()` drops a stray byte within an
+ * identifier or operator, the span of the token still covers it, and where it moves an
+ * unexpected byte out of an operator, the spans of the two are not in source order. The
+ * other overloads record no positions at all.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param tokens The buffer to fill.
+ * @param spans The list to fill with the span of each token.
+ * @throws std::length_error If the formula is too long for 32-bit offsets.
+ */
+void lex(std::string_view formula, TokenBuffer& tokens, std::vector<SourceSpan>& spans);
+
+/**
+ * @brief Tokenizes a given QML formula, interning every literal into `symbols`.
+ *
+ * Produces the same tokens as `lex()`, into `tokens`, whose contents are replaced. Their
+ * literals are views of the names stored in `symbols`, so they stay valid after `formula`
+ * is gone, for as long as the table lives, and equal literals share their storage.
+ * Several threads may lex into the same table at once.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param tokens The list to fill with `TokenView` objects.
+ * @param symbols The table to intern the literals into.
+ */
+void lex(std::string_view formula, std::vector<TokenView>& tokens, SymbolTable& symbols);
+
+/**
+ * @brief Tokenizes a given QML formula without copying any literal.
+ *
+ * Every token refers to a contiguous slice of `formula`, which must therefore outlive the
+ * returned tokens. On well-formed input the result matches `lex()` token for token. On
+ * malformed input the tokens are kept in source order: an unexpected byte ends the pending
+ * identifier or operator instead of being hoisted out of it, and stray UTF-8 continuation
+ * bytes are reported as `ILLEGAL` rather than dropped.
+ *
+ * @param formula The input string representing a QML formula.
+ * @return A vector of `TokenView` objects.
+ */
+std::vector<TokenView> lex_view(std::string_view formula);
+
+/**
+ * @brief Tokenizes a given QML formula lazily, one token at a time.
+ *
+ * Yields the same tokens as `lex_view()`, `EOI` included, but computes each only when it
+ * is asked for, through a `Lexer`, so no list is built and stopping early skips the rest
+ * of the formula. `formula` must outlive the generator and every token it yields.
+ *
+ * @param formula The input string representing a QML formula.
+ * @return A generator of `TokenView` objects.
+ */
+Generator<TokenView> lex_lazy(std::string_view formula);
+
+/**
+ * @class Lexer
+ * @brief Tokenizes a QML formula on demand.
+ *
+ * Produces the same tokens as `lex_view()`, one at a time, keeping only a small window of
+ * lookahead instead of the whole token list. Literals refer to `formula`, which must outlive
+ * the lexer and every token it returns. Once the input is exhausted, the lexer keeps
+ * returning the `EOI` token.
+ */
+class Lexer
+{
+public:
+    /**
+     * @brief The number of tokens that can be looked at without consuming them.
+     *
+     * Matches the deepest lookahead of the parser, which is `predication()`.
+     */
+    static constexpr size_t max_lookahead = 4;
+
+    explicit Lexer(std::string_view formula);
+
+    TokenView next();
+    TokenView peek(size_t offset = 0);
+
+    size_t offset();
+    void seek(size_t offset);
+
+private:
+    void fill(size_t count);
+    void push(std::string_view literal, TokenType type);
+
+    // A step of the DFA emits at most two tokens, so the buffer may briefly hold
+    // two more than the lookahead asks for; the size is kept a power of two.
+    static constexpr size_t buffer_size = 8;
+
+    std::string_view m_Formula;
+    size_t m_Position;
+    uint8_t m_State;
+    size_t m_OperatorBegin;
+    size_t m_IdentifierBegin;
+    size_t m_IdentifierLength;
+    bool m_Exhausted;
+    std::array<std::string_view, buffer_size> m_Literals;
+    std::array<TokenType, buffer_size> m_Types;
+    size_t m_Head;
+    size_t m_Count;
+};
+
 }
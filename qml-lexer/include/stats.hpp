@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @struct ParseStats
+ * @brief Counts the work done by the lexer and the parser.
+ *
+ * Only filled in when the library is built with `QMLPARSER_ENABLE_STATS`; otherwise every
+ * counter stays at zero, and counting costs nothing.
+ */
+struct ParseStats {
+    /// Tokens produced by the lexer, EOI included.
+    uint64_t tokens = 0;
+    /// Tokens copied into a parser from a list it was given.
+    uint64_t copied_tokens = 0;
+    /// Expression nodes allocated.
+    uint64_t nodes = 0;
+    /// Bytes allocated for those nodes, reference counts included.
+    uint64_t node_bytes = 0;
+    /// Times `predication()` went back to the predicate after a malformed argument list.
+    uint64_t backtracks = 0;
+    /// The deepest nesting of prefixes and brackets.
+    uint64_t max_depth = 0;
+    /// Time spent lexing.
+    std::chrono::nanoseconds lex_time{};
+    /// Time spent parsing the tokens.
+    std::chrono::nanoseconds parse_time{};
+
+    ParseStats& operator+=(const ParseStats& other);
+};
+
+#ifdef QMLPARSER_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+/**
+ * @brief Gives the counters of the last call to finish on this thread.
+ *
+ * A call is one of the functions that lex or parse, such as `lex()`, `parse()` or
+ * `BasicParser::parse()`. When one calls another, as `parse()` calls `lex()`, the work of
+ * both is counted as one call, that of the outermost one. Work done outside of any call,
+ * such as lexing through a `Lexer`, is counted in the next call to finish.
+ */
+const ParseStats& last_stats();
+
+/**
+ * @brief Gives the counters of every call finished on this thread since the last reset.
+ *
+ * Calls made on other threads, such as the workers of `parse_batch()`, are not included:
+ * to count those, add up what a callback set with `set_stats_callback()` is given.
+ * `max_depth` is the deepest of all the calls.
+ */
+const ParseStats& thread_total_stats();
+
+/**
+ * @brief Sets the counters of this thread back to zero.
+ */
+void reset_stats();
+
+/**
+ * @brief Sets a function to be given the counters of every call, on the thread that made it.
+ *
+ * Meant for exporting the counters to a metrics system. The callback is shared by all
+ * threads, so it must be safe to call from several of them at once. It may be replaced
+ * at any time: a call that finishes while it is being replaced is given to either the old
+ * function or the new one, and the old one is destroyed once no thread is calling it.
+ *
+ * @param callback The function to call, or an empty function to stop.
+ */
+void set_stats_callback(std::function<void(const ParseStats&)> callback);
+
+namespace detail {
+    // The counters of the call in progress on this thread.
+    ParseStats& pending_stats();
+
+    void enter_stats();
+    void leave_stats();
+
+    // Marks a call: the counters are published when the outermost one ends.
+    class StatsScope
+    {
+    public:
+        StatsScope()
+        {
+            if constexpr (stats_enabled) {
+                enter_stats();
+            }
+        }
+
+        ~StatsScope()
+        {
+            if constexpr (stats_enabled) {
+                leave_stats();
+            }
+        }
+
+        StatsScope(const StatsScope&) = delete;
+        StatsScope& operator=(const StatsScope&) = delete;
+    };
+
+    // Adds the time until it is destroyed to one of the timers.
+    class StatsTimer
+    {
+    public:
+        explicit StatsTimer(std::chrono::nanoseconds ParseStats::* timer)
+        {
+            if constexpr (stats_enabled) {
+                m_Timer = timer;
+                m_Start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~StatsTimer()
+        {
+            if constexpr (stats_enabled) {
+                pending_stats().*m_Timer += std::chrono::steady_clock::now() - m_Start;
+            }
+        }
+
+        StatsTimer(const StatsTimer&) = delete;
+        StatsTimer& operator=(const StatsTimer&) = delete;
+
+    private:
+        std::chrono::nanoseconds ParseStats::* m_Timer = nullptr;
+        std::chrono::steady_clock::time_point m_Start;
+    };
+
+    inline void count(uint64_t ParseStats::* counter, uint64_t amount)
+    {
+        if constexpr (stats_enabled) {
+            pending_stats().*counter += amount;
+        }
+    }
+
+    inline void record_depth(uint64_t depth)
+    {
+        if constexpr (stats_enabled) {
+            ParseStats& stats = pending_stats();
+            stats.max_depth = std::max(stats.max_depth, depth);
+        }
+    }
+}
+
+}
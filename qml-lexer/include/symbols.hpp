@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class SymbolTable
+ * @brief Stores each distinct literal once, and numbers them.
+ *
+ * Interning a name returns a compact `Symbol` for it, and the same one every time. The
+ * stored names never move and are never removed, so the view returned by `name()` stays
+ * valid for as long as the table lives, and a table can be kept across any number of
+ * batches of formulas.
+ *
+ * The table can be used from many threads at once. Lookups, `find()` and `name()` take no
+ * lock; only `intern()`, when the name is not in the table yet, serializes with other
+ * writers.
+ */
+class SymbolTable
+{
+public:
+    using Symbol = uint32_t;
+
+    SymbolTable();
+    ~SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Symbol intern(std::string_view name);
+    std::optional<Symbol> find(std::string_view name) const;
+    std::string_view name(Symbol symbol) const;
+    size_t size() const;
+
+private:
+    // An open-addressing index from names to symbols; each slot holds the upper half of the
+    // hash of the name and the symbol plus one, or zero when empty.
+    struct Index {
+        explicit Index(size_t capacity);
+
+        size_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    };
+
+    // Symbols are numbered into segments that double in size, so none ever moves.
+    static constexpr size_t first_segment_bits = 6;
+    static constexpr size_t segment_count = 32 - first_segment_bits;
+
+    std::optional<Symbol> lookup(const Index& index, std::string_view name, size_t hash) const;
+    static void insert(Index& index, Symbol symbol, size_t hash);
+    std::string_view store(std::string_view name);
+    std::atomic<std::string_view*>& segment(Symbol symbol, size_t& offset);
+    const std::atomic<std::string_view*>& segment(Symbol symbol, size_t& offset) const;
+
+    std::atomic<size_t> m_Size;
+    std::atomic<Index*> m_Index;
+    std::array<std::atomic<std::string_view*>, segment_count> m_Segments;
+
+    // Only touched with m_Mutex held.
+    std::mutex m_Mutex;
+    std::vector<std::unique_ptr<Index>> m_Indexes;
+    std::vector<std::unique_ptr<char[]>> m_Blocks;
+    size_t m_BlockUsed;
+    size_t m_BlockSize;
+};
+
+}
@@ -4,314 +4,462 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "lexer.hpp"
+#include "dfa.hpp"
+#include "scan.hpp"
+#include "stats.hpp"
 
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <ranges>
-#include <unordered_map>
+#include <stdexcept>
 
 #include <QMLExpression/expression.hpp>
 
 namespace iif_sadaf::talk::QMLParser {
 
 namespace {
-    const std::unordered_map<uint8_t, std::unordered_map<char, uint8_t>> variable_dfa = {
-        {0, { { 'x', 1 },
-              { 'y', 1 },
-              { 'z', 1 } }
-        },
-        {1, { { '_', 2 },
-              { '0', 3 },
-              { '1', 3 },
-              { '2', 3 },
-              { '3', 3 },
-              { '4', 3 },
-              { '5', 3 },
-              { '6', 3 },
-              { '7', 3 },
-              { '8', 3 },
-              { '9', 3 } }
-        },
-        {2, { { '0', 3 },
-              { '1', 3 },
-              { '2', 3 },
-              { '3', 3 },
-              { '4', 3 },
-              { '5', 3 },
-              { '6', 3 },
-              { '7', 3 },
-              { '8', 3 },
-              { '9', 3 } }
-        },
-        {3, { { '0', 3 },
-              { '1', 3 },
-              { '2', 3 },
-              { '3', 3 },
-              { '4', 3 },
-              { '5', 3 },
-              { '6', 3 },
-              { '7', 3 },
-              { '8', 3 },
-              { '9', 3 } }
+    using namespace detail;
+
+    // Skips runs with the vector scanners of scan.hpp.
+    struct VectorScanner {
+        static size_t identifier(std::string_view text, size_t pos)
+        {
+            return scanIdentifier(text, pos);
+        }
+
+        static size_t spaces(std::string_view text, size_t pos)
+        {
+            return scanSpaces(text, pos);
         }
     };
 
-    const uint8_t final_states[2] = {1, 3};
-    const uint8_t initial_state = 0;
+    template<bool Ordered, typename Sink>
+    size_t step(std::string_view formula, size_t i, Cursor& cursor, Sink& sink)
+    {
+        return detail::step<Ordered, VectorScanner>(formula, i, cursor, sink);
+    }
 
-    bool isVariable(const std::string& token)
+    template<bool Ordered, typename Sink>
+    void run(std::string_view formula, Sink& sink)
     {
-        uint8_t state = initial_state;
-        for (const char c : token) {
-            if (!variable_dfa.at(state).contains(c)) {
-                return false;
-            }
-            state = variable_dfa.at(state).at(c);
-        }
-        return state == final_states[0] || state == final_states[1];
+        detail::run<Ordered, VectorScanner>(formula, sink);
     }
 
-    void writeToTokenList(std::string& token, std::vector<Token>& list)
+    /*
+     * The bytes of the pending identifier, for the sinks below. Kept per thread, so that
+     * lexing one formula after another stops allocating once it has grown to fit the
+     * longest identifier; every sink below lives only for one call, on one thread.
+     */
+    std::string& identifierScratch()
     {
-        if (token.empty()) {
-            return;
-        }
+        thread_local std::string identifier;
+        identifier.clear();
+        return identifier;
+    }
 
-        if (isVariable(token)) {
-            list.emplace_back(token, TokenType::VARIABLE);
-        }
-        else {
-            list.emplace_back(token, TokenType::IDENTIFIER);
+    /*
+     * Collects the tokens of lex(). Identifiers are accumulated byte by byte, since the
+     * legacy transitions do not guarantee they are contiguous in the input. Tokens already
+     * in `list` are overwritten in place, so that refilling a list reuses its strings.
+     */
+    struct OwningSink {
+        std::vector<Token>& list;
+        std::string& identifier = identifierScratch();
+        size_t count = 0;
+
+        void append(std::string_view formula, size_t pos, size_t length)
+        {
+            identifier.append(formula.substr(pos, length));
+        }
+
+        void flushIdentifier()
+        {
+            if (identifier.empty()) {
+                return;
+            }
+            emit(identifier, isVariable(identifier) ? TokenType::VARIABLE : TokenType::IDENTIFIER);
+            identifier.clear();
         }
-        token.clear();
-    }
 
-    void writeToTokenList(std::vector<uint8_t>& token_byte_array, TokenType type, std::vector<Token>& list)
-    {
-        if (token_byte_array.empty()) {
-            return;
+        void emit(std::string_view literal, TokenType type)
+        {
+            if (count < list.size()) {
+                list[count].literal.assign(literal);
+                list[count].type = type;
+            }
+            else {
+                list.emplace_back(std::string(literal), type);
+            }
+            ++count;
         }
 
-        std::string token_str;
-        for (uint8_t const c : token_byte_array) {
-            token_str.push_back(c);
+        void truncate()
+        {
+            list.erase(list.begin() + static_cast<std::ptrdiff_t>(count), list.end());
         }
-        list.emplace_back(token_str, type);
-        token_byte_array.clear();
-    }
+    };
 
-    bool isValidIdentifierSymbol(uint8_t c)
-    {
-        return c == '_'
-            || c == '.'
-            || (c >= '0' && c <= '9')
-            || (c >= 'A' && c <= 'Z')
-            || (c >= 'a' && c <= 'z')
-        ;
-    }
-}
+    /*
+     * Collects the tokens of lex() into a TokenBuffer. Identifiers are accumulated as in
+     * OwningSink.
+     */
+    struct CompactSink {
+        TokenBuffer& tokens;
+        std::string& identifier = identifierScratch();
 
-std::vector<Token> lex(const std::string& formula)
-{
-    std::vector<Token> list;
-    std::string identifier;
-    std::vector<uint8_t> operator_byte_array;
+        void append(std::string_view formula, size_t pos, size_t length)
+        {
+            identifier.append(formula.substr(pos, length));
+        }
 
-    const auto flush = [&](TokenType type) -> void {
-        writeToTokenList(identifier, list);
-        writeToTokenList(operator_byte_array, type, list);
-    };
-    const auto addToList = [&](const std::string& literal, TokenType type) -> void {
-        flush(TokenType::ILLEGAL);
-        list.emplace_back(literal, type);
-    };
-    const auto initOp = [&](uint8_t curr) -> void {
-        flush(TokenType::ILLEGAL);
-        operator_byte_array.push_back(curr);
-    };
-    const auto addToOp = [&](uint8_t curr, uint8_t prev) -> void {
-        if (!operator_byte_array.empty() && operator_byte_array.back() == prev) {
-            operator_byte_array.push_back(curr);
+        void flushIdentifier()
+        {
+            if (identifier.empty()) {
+                return;
+            }
+            emit(identifier, isVariable(identifier) ? TokenType::VARIABLE : TokenType::IDENTIFIER);
+            identifier.clear();
         }
-        else {
-            writeToTokenList(operator_byte_array, TokenType::ILLEGAL, list);
+
+        void emit(std::string_view literal, TokenType type)
+        {
+            tokens.push(literal, type);
         }
     };
-    const auto addToOpAndFlush = [&](uint8_t curr, uint8_t prev, TokenType type) -> void {
-        if (!operator_byte_array.empty() && operator_byte_array.back() == prev) {
-            operator_byte_array.push_back(curr);
-            writeToTokenList(operator_byte_array, type, list);
+
+    /*
+     * Collects the tokens of lex() into views of `symbols`. Identifiers are accumulated as
+     * in OwningSink, and every literal is interned once complete.
+     */
+    struct InterningSink {
+        std::vector<TokenView>& list;
+        SymbolTable& symbols;
+        std::string& identifier = identifierScratch();
+
+        void append(std::string_view formula, size_t pos, size_t length)
+        {
+            identifier.append(formula.substr(pos, length));
         }
-        else {
-            writeToTokenList(operator_byte_array, TokenType::ILLEGAL, list);
+
+        void flushIdentifier()
+        {
+            if (identifier.empty()) {
+                return;
+            }
+            emit(identifier, isVariable(identifier) ? TokenType::VARIABLE : TokenType::IDENTIFIER);
+            identifier.clear();
         }
-    };
 
-    for (const uint8_t c : formula) {
-        /*******************
-         * SKIP WHITESPACE *
-         *******************/
+        void emit(std::string_view literal, TokenType type)
+        {
+            list.emplace_back(symbols.name(symbols.intern(literal)), type);
+        }
+    };
 
-        if (c == ' ') {
-            flush(TokenType::ILLEGAL);
-            continue;
+    /*
+     * Collects the tokens of lex_view() and Lexer into `list`, which only needs an
+     * emplace_back(). Under the ordered transitions every token, identifiers included,
+     * is a contiguous slice of the input.
+     */
+    template<typename List>
+    struct ViewSink {
+        List& list;
+        std::string_view formula;
+        size_t identifier_begin = 0;
+        size_t identifier_length = 0;
+
+        void append(std::string_view, size_t pos, size_t length)
+        {
+            if (identifier_length == 0) {
+                identifier_begin = pos;
+            }
+            identifier_length += length;
         }
 
-        /***************
-         * PUNCTUATION *
-         ***************/
+        void flushIdentifier()
+        {
+            if (identifier_length == 0) {
+                return;
+            }
+            const std::string_view identifier = formula.substr(identifier_begin, identifier_length);
+            list.emplace_back(identifier, isVariable(identifier) ? TokenType::VARIABLE : TokenType::IDENTIFIER);
+            identifier_length = 0;
+        }
 
-        else if (c == '(') {
-            addToList("(", TokenType::LPAREN);
+        void emit(std::string_view literal, TokenType type)
+        {
+            list.emplace_back(literal, type);
         }
-        else if (c == ')') {
-            addToList(")", TokenType::RPAREN);
+    };
+
+
+    /*
+     * Collects the tokens of lex() as CompactSink does, and the bytes each comes from into
+     * `spans`: an identifier runs from its first appended byte to its last, and operators
+     * and punctuation are located by the DFA.
+     */
+    struct SpanningSink {
+        TokenBuffer& tokens;
+        std::vector<SourceSpan>& spans;
+        std::string& identifier = identifierScratch();
+        SourceSpan identifierSpan = {};
+        SourceSpan next = {};
+
+        void append(std::string_view formula, size_t pos, size_t length)
+        {
+            if (identifier.empty()) {
+                identifierSpan.begin = static_cast<uint32_t>(pos);
+            }
+            identifierSpan.end = static_cast<uint32_t>(pos + length);
+            identifier.append(formula.substr(pos, length));
         }
-        else if (c == '[') {
-            addToList("[", TokenType::LBRACKET);
+
+        void flushIdentifier()
+        {
+            if (identifier.empty()) {
+                return;
+            }
+            next = identifierSpan;
+            emit(identifier, isVariable(identifier) ? TokenType::VARIABLE : TokenType::IDENTIFIER);
+            identifier.clear();
         }
-        else if (c == ']') {
-            addToList("]", TokenType::RBRACKET);
+
+        void locate(size_t begin, size_t end)
+        {
+            next = { static_cast<uint32_t>(begin), static_cast<uint32_t>(end) };
         }
-        else if (c == ',') {
-            addToList(",", TokenType::COMMA);
+
+        void emit(std::string_view literal, TokenType type)
+        {
+            tokens.push(literal, type);
+            spans.push_back(next);
         }
+    };
 
-        /*********************
-         * LOGICAL OPERATORS *
-         *********************/
+}
 
-        /************
-         * NEGATION *
-         ************/
+std::vector<Token> lex(const std::string& formula)
+{
+    std::vector<Token> list;
+    list.reserve(formula.size() / 2 + 1);
+    lex(formula, list);
 
-        else if (c == 0xc2) { // first byte of negation
-            initOp(0xc2);
-        }
+    return list;
+}
 
-        else if (c == 0xAC) { // second byte of negation
-            addToOpAndFlush(0xAC, 0xc2, TokenType::NOT);
-        }
+void lex(std::string_view formula, std::vector<Token>& tokens)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::lex_time);
 
-        /*******************
-         * OTHER OPERATORS *
-         *******************/
+    OwningSink sink{ tokens };
+    run<false>(formula, sink);
 
-        else if (c == 0xe2) { // first byte of all other operators
-            initOp(0xe2);
-        }
+    sink.emit("EOI", TokenType::EOI);
+    sink.truncate();
 
-        /*******************************
-         * IMPLICATION AND EQUIVALENCE *
-         *******************************/
+    detail::count(&ParseStats::tokens, tokens.size());
+}
 
-        else if (c == 0x86) { // second byte of implication and equivalence
-            addToOp(0x86, 0xe2);
-        }
+void lex(std::string_view formula, TokenBuffer& tokens)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::lex_time);
 
-        else if (c == 0x92) { // third byte of implication
-            addToOpAndFlush(0x92, 0x86, TokenType::IF);
-        }
+    tokens.clear();
+    CompactSink sink{ tokens };
+    run<false>(formula, sink);
 
-        else if (c == 0x94) { // third byte of equivalence
-            addToOpAndFlush(0x94, 0x86, TokenType::EQ);
-        }
+    sink.emit("EOI", TokenType::EOI);
 
-        /***************
-         * QUANTIFIERS *
-         ***************/
+    detail::count(&ParseStats::tokens, tokens.size());
+}
 
-        else if (c == 0x88) { // second byte of forall, exists, not_exists, conjunction, disjunction
-            addToOp(0x88, 0xe2);
-        }
+void lex(std::string_view formula, TokenBuffer& tokens, std::vector<SourceSpan>& spans)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::lex_time);
 
-        else if (c == 0x80) { // third byte of forall
-            addToOpAndFlush(0x80, 0x88, TokenType::FORALL);
-        }
+    if (formula.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("lex(): formula too long for its source spans");
+    }
 
-        else if (c == 0x83) { // third byte of exists
-            addToOpAndFlush(0x83, 0x88, TokenType::EXISTS);
-        }
+    tokens.clear();
+    spans.clear();
+    SpanningSink sink{ tokens, spans };
+    run<false>(formula, sink);
 
-        else if (c == 0x84) { // third byte of not_exists, third byte of possibility
-            if (!operator_byte_array.empty()) {
-                switch (operator_byte_array.back()) {
-                case 0x88:
-                    operator_byte_array.push_back(0x84);
-                    writeToTokenList(operator_byte_array, TokenType::NOT_EXISTS, list);
-                    break;
-                case 0x8B:
-                    operator_byte_array.push_back(0x84);
-                    writeToTokenList(operator_byte_array, TokenType::POS, list);
-                    break;
-                default:
-                    writeToTokenList(operator_byte_array, TokenType::ILLEGAL, list);
-                    break;
-                }
-            }
-            else {
-                writeToTokenList(operator_byte_array, TokenType::ILLEGAL, list);
-            }
-        }
+    sink.locate(formula.size(), formula.size());
+    sink.emit("EOI", TokenType::EOI);
 
-        else if (c == 0xA7) { // third byte of conjunction
-            addToOpAndFlush(0xA7, 0x88, TokenType::AND);
-        }
+    detail::count(&ParseStats::tokens, tokens.size());
+}
 
-        else if (c == 0xA8) { // third byte of disjunction
-            addToOpAndFlush(0xA8, 0x88, TokenType::OR);
-        }
+void lex(std::string_view formula, std::vector<TokenView>& tokens, SymbolTable& symbols)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::lex_time);
 
-        /**************
-         * INEQUALITY *
-         **************/
+    tokens.clear();
+    InterningSink sink{ tokens, symbols };
+    run<false>(formula, sink);
 
-        else if (c == 0x89) { // second byte of inequality
-            addToOp(0x89, 0xe2);
-        }
+    sink.emit("EOI", TokenType::EOI);
 
-        else if (c == 0xA0) { // third byte of inequality
-            addToOpAndFlush(0xA0, 0x89, TokenType::NEQ);
-        }
+    detail::count(&ParseStats::tokens, tokens.size());
+}
 
-        /******************
-        * MODAL OPERATORS *
-        *******************/
+std::vector<TokenView> lex_view(std::string_view formula)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::lex_time);
 
-        else if (c == 0x8B) { // second byte of possibility
-             addToOp(0x8B, 0xe2);
-        }
+    std::vector<TokenView> list;
+    list.reserve(formula.size() / 2 + 1);
+    ViewSink<std::vector<TokenView>> sink{ list, formula };
+    run<true>(formula, sink);
 
-        else if (c == 0x96) { // second byte of necessity
-            addToOp(0x96, 0xe2);
-        }
+    list.emplace_back("EOI", TokenType::EOI);
+
+    detail::count(&ParseStats::tokens, list.size());
+
+    return list;
+}
 
-        else if (c == 0xA1) { // third byte of necessity
-            addToOpAndFlush(0xA1, 0x96, TokenType::NEC);
+Generator<TokenView> lex_lazy(std::string_view formula)
+{
+    // `formula` is a view, so the coroutine frame holds no copy of the text.
+    Lexer lexer(formula);
+    for (;;) {
+        TokenView token = lexer.next();
+        const bool last = token.type == TokenType::EOI;
+        co_yield std::move(token);
+        if (last) {
+            co_return;
         }
+    }
+}
+
+/**
+ * @brief Constructs a Lexer over `formula`, which must outlive it.
+ * @param formula The input string representing a QML formula.
+ */
+Lexer::Lexer(std::string_view formula)
+    : m_Formula(formula), m_Position(0), m_State(START), m_OperatorBegin(0), m_IdentifierBegin(0),
+      m_IdentifierLength(0), m_Exhausted(false), m_Literals(), m_Types(), m_Head(0), m_Count(0)
+{
+}
 
+/**
+ * @brief Consumes the current token.
+ * @return The token that was current before the call. At the end of the input, `EOI`.
+ */
+TokenView Lexer::next()
+{
+    const TokenView token = peek();
+    if (token.type != TokenType::EOI) {
+        m_Head = (m_Head + 1) % buffer_size;
+        --m_Count;
+    }
+    return token;
+}
 
-        /*******************
-         * ALL IDENTIFIERS *
-         *******************/
+/**
+ * @brief Looks at a token ahead of the current one without consuming anything.
+ * @param offset How far ahead to look; 0 is the current token. Must be below `max_lookahead`.
+ * @return The token at `offset`, or `EOI` if the input ends before it.
+ */
+TokenView Lexer::peek(size_t offset)
+{
+    if (offset >= max_lookahead) {
+        throw std::out_of_range("Lexer lookahead exceeds max_lookahead");
+    }
 
-        else if (c == '=') {
-            flush(TokenType::ILLEGAL);
-            list.emplace_back(Token("=", TokenType::ID));
-        }
+    fill(offset + 1);
+    const size_t slot = (m_Head + std::min(offset, m_Count - 1)) % buffer_size;
+    return TokenView(m_Literals[slot], m_Types[slot]);
+}
 
-        else if (isValidIdentifierSymbol(c)) {
-            identifier.push_back(c);
+/**
+ * @brief Returns the position of the current token in the input.
+ *
+ * Together with `seek()`, this lets a caller return to a token it has already seen.
+ *
+ * @return The byte offset of the current token, or the input size at the end of the input.
+ */
+size_t Lexer::offset()
+{
+    const TokenView token = peek();
+    if (token.type == TokenType::EOI) {
+        return m_Formula.size();
+    }
+    return static_cast<size_t>(token.literal.data() - m_Formula.data());
+}
+
+/**
+ * @brief Restarts lexing at `offset`, which must have been returned by `offset()`.
+ *
+ * No state survives a token boundary, so lexing from the start of a token yields the same
+ * tokens as the first time around.
+ *
+ * @param offset The byte offset of the token to make current.
+ */
+void Lexer::seek(size_t offset)
+{
+    m_Position = offset;
+    m_State = START;
+    m_IdentifierLength = 0;
+    m_Exhausted = false;
+    m_Head = 0;
+    m_Count = 0;
+}
+
+// Runs the DFA until `count` tokens are buffered or the input is exhausted.
+void Lexer::fill(size_t count)
+{
+    if (m_Count >= count || m_Exhausted) {
+        return;
+    }
+
+    struct Ring {
+        Lexer& lexer;
+
+        void emplace_back(std::string_view literal, TokenType type)
+        {
+            lexer.push(literal, type);
         }
+    };
 
+    Ring ring{ *this };
+    ViewSink<Ring> sink{ ring, m_Formula, m_IdentifierBegin, m_IdentifierLength };
+    Cursor cursor{ static_cast<State>(m_State), m_OperatorBegin };
+
+    while (m_Count < count && !m_Exhausted) {
+        if (m_Position < m_Formula.size()) {
+            m_Position = step<true>(m_Formula, m_Position, cursor, sink);
+        }
         else {
-            list.emplace_back(Token(std::string(1, c), TokenType::ILLEGAL));
+            finish<true>(m_Formula, cursor, sink);
+            push("EOI", TokenType::EOI);
+            m_Exhausted = true;
         }
     }
 
-    flush(TokenType::ILLEGAL);
+    m_State = cursor.state;
+    m_OperatorBegin = cursor.operator_begin;
+    m_IdentifierBegin = sink.identifier_begin;
+    m_IdentifierLength = sink.identifier_length;
+}
 
-    list.emplace_back("EOI", TokenType::EOI);
+void Lexer::push(std::string_view literal, TokenType type)
+{
+    const size_t slot = (m_Head + m_Count) % buffer_size;
+    m_Literals[slot] = literal;
+    m_Types[slot] = type;
+    ++m_Count;
 
-    return list;
+    detail::count(&ParseStats::tokens, 1);
 }
 
 }
@@ -0,0 +1,230 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "dfa.hpp"
+
+#if !defined(QMLPARSER_NO_SIMD)
+    #if defined(__AVX2__)
+        #include <immintrin.h>
+        #define QMLPARSER_SCAN_AVX2
+    #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #include <emmintrin.h>
+        #define QMLPARSER_SCAN_SSE2
+    #elif defined(__ARM_NEON) || defined(_M_ARM64)
+        #include <arm_neon.h>
+        #define QMLPARSER_SCAN_NEON
+    #endif
+#endif
+
+/*
+ * Scanners for the two kinds of runs that dominate real formulas: identifier bytes
+ * ([A-Za-z0-9_.]) and spaces. Each returns the position of the first byte at or after
+ * `pos` that does not belong to the run. The vector versions test 16 or 32 bytes per step
+ * and finish with the scalar loop, so they never read past the end of the input.
+ */
+namespace iif_sadaf::talk::QMLParser::detail {
+
+inline size_t scanIdentifierScalar(std::string_view text, size_t pos)
+{
+    while (pos < text.size() && isIdentifierByte(static_cast<uint8_t>(text[pos]))) {
+        ++pos;
+    }
+    return pos;
+}
+
+inline size_t scanSpacesScalar(std::string_view text, size_t pos)
+{
+    while (pos < text.size() && text[pos] == ' ') {
+        ++pos;
+    }
+    return pos;
+}
+
+// Most runs are short (a variable, a single space), and for those one scalar pass over a
+// few bytes beats setting up a vector compare. Returns true if the run ended within it.
+inline bool scanShortIdentifier(std::string_view text, size_t& pos)
+{
+    const size_t end = pos + 8 < text.size() ? pos + 8 : text.size();
+    while (pos < end && isIdentifierByte(static_cast<uint8_t>(text[pos]))) {
+        ++pos;
+    }
+    return pos < end || pos == text.size();
+}
+
+inline bool scanShortSpaces(std::string_view text, size_t& pos)
+{
+    const size_t end = pos + 8 < text.size() ? pos + 8 : text.size();
+    while (pos < end && text[pos] == ' ') {
+        ++pos;
+    }
+    return pos < end || pos == text.size();
+}
+
+#if defined(QMLPARSER_SCAN_AVX2)
+
+// Signed comparisons are safe: bytes >= 0x80 are negative and fall outside every range.
+inline uint32_t identifierMask(__m256i bytes)
+{
+    const __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    const __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                                            _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes));
+    const __m256i punct = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')),
+                                          _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('.')));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), punct)));
+}
+
+inline size_t scanIdentifier(std::string_view text, size_t pos)
+{
+    if (scanShortIdentifier(text, pos)) {
+        return pos;
+    }
+    while (pos + 32 <= text.size()) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + pos));
+        const uint32_t outside = ~identifierMask(bytes);
+        if (outside != 0) {
+            return pos + std::countr_zero(outside);
+        }
+        pos += 32;
+    }
+    return scanIdentifierScalar(text, pos);
+}
+
+inline size_t scanSpaces(std::string_view text, size_t pos)
+{
+    if (scanShortSpaces(text, pos)) {
+        return pos;
+    }
+    while (pos + 32 <= text.size()) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + pos));
+        const uint32_t outside = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '))));
+        if (outside != 0) {
+            return pos + std::countr_zero(outside);
+        }
+        pos += 32;
+    }
+    return scanSpacesScalar(text, pos);
+}
+
+#elif defined(QMLPARSER_SCAN_SSE2)
+
+// Signed comparisons are safe: bytes >= 0x80 are negative and fall outside every range.
+inline uint32_t identifierMask(__m128i bytes)
+{
+    const __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                         _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+    const __m128i punct = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')),
+                                       _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.')));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), punct)));
+}
+
+inline size_t scanIdentifier(std::string_view text, size_t pos)
+{
+    if (scanShortIdentifier(text, pos)) {
+        return pos;
+    }
+    while (pos + 16 <= text.size()) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+        const uint32_t outside = ~identifierMask(bytes) & 0xFFFF;
+        if (outside != 0) {
+            return pos + std::countr_zero(outside);
+        }
+        pos += 16;
+    }
+    return scanIdentifierScalar(text, pos);
+}
+
+inline size_t scanSpaces(std::string_view text, size_t pos)
+{
+    if (scanShortSpaces(text, pos)) {
+        return pos;
+    }
+    while (pos + 16 <= text.size()) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+        const uint32_t outside = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')))) & 0xFFFF;
+        if (outside != 0) {
+            return pos + std::countr_zero(outside);
+        }
+        pos += 16;
+    }
+    return scanSpacesScalar(text, pos);
+}
+
+#elif defined(QMLPARSER_SCAN_NEON)
+
+// NEON has no movemask; narrowing the comparison result leaves one nibble per byte.
+inline uint64_t nibbleMask(uint8x16_t matches)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+
+inline uint8x16_t identifierMatches(uint8x16_t bytes)
+{
+    const uint8x16_t folded = vorrq_u8(bytes, vdupq_n_u8(0x20));
+    const uint8x16_t letter = vcltq_u8(vsubq_u8(folded, vdupq_n_u8('a')), vdupq_n_u8(26));
+    const uint8x16_t digit = vcltq_u8(vsubq_u8(bytes, vdupq_n_u8('0')), vdupq_n_u8(10));
+    const uint8x16_t punct = vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('_')), vceqq_u8(bytes, vdupq_n_u8('.')));
+    return vorrq_u8(vorrq_u8(letter, digit), punct);
+}
+
+inline size_t scanIdentifier(std::string_view text, size_t pos)
+{
+    if (scanShortIdentifier(text, pos)) {
+        return pos;
+    }
+    while (pos + 16 <= text.size()) {
+        const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(text.data() + pos));
+        const uint64_t outside = ~nibbleMask(identifierMatches(bytes));
+        if (outside != 0) {
+            return pos + std::countr_zero(outside) / 4;
+        }
+        pos += 16;
+    }
+    return scanIdentifierScalar(text, pos);
+}
+
+inline size_t scanSpaces(std::string_view text, size_t pos)
+{
+    if (scanShortSpaces(text, pos)) {
+        return pos;
+    }
+    while (pos + 16 <= text.size()) {
+        const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(text.data() + pos));
+        const uint64_t outside = ~nibbleMask(vceqq_u8(bytes, vdupq_n_u8(' ')));
+        if (outside != 0) {
+            return pos + std::countr_zero(outside) / 4;
+        }
+        pos += 16;
+    }
+    return scanSpacesScalar(text, pos);
+}
+
+#else
+
+inline size_t scanIdentifier(std::string_view text, size_t pos)
+{
+    return scanIdentifierScalar(text, pos);
+}
+
+inline size_t scanSpaces(std::string_view text, size_t pos)
+{
+    return scanSpacesScalar(text, pos);
+}
+
+#endif
+
+}
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "stats.hpp"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    struct ThreadStats {
+        ParseStats pending;
+        ParseStats last;
+        ParseStats total;
+        // How many calls are in progress, one inside the other.
+        unsigned depth = 0;
+    };
+
+    ThreadStats& threadStats()
+    {
+        thread_local ThreadStats stats;
+        return stats;
+    }
+
+    using Callback = std::function<void(const ParseStats&)>;
+
+    /*
+     * Read by every thread as its calls finish. The lock is only held to copy the pointer,
+     * so that a callback being replaced is kept alive until the calls running it return.
+     */
+    struct SharedCallback {
+        std::mutex mutex;
+        std::shared_ptr<const Callback> function;
+    };
+
+    SharedCallback& callback()
+    {
+        static SharedCallback callback;
+        return callback;
+    }
+
+    std::shared_ptr<const Callback> currentCallback()
+    {
+        SharedCallback& shared = callback();
+        const std::lock_guard<std::mutex> lock(shared.mutex);
+        return shared.function;
+    }
+}
+
+ParseStats& ParseStats::operator+=(const ParseStats& other)
+{
+    tokens += other.tokens;
+    copied_tokens += other.copied_tokens;
+    nodes += other.nodes;
+    node_bytes += other.node_bytes;
+    backtracks += other.backtracks;
+    max_depth = std::max(max_depth, other.max_depth);
+    lex_time += other.lex_time;
+    parse_time += other.parse_time;
+    return *this;
+}
+
+const ParseStats& last_stats()
+{
+    return threadStats().last;
+}
+
+const ParseStats& thread_total_stats()
+{
+    return threadStats().total;
+}
+
+void reset_stats()
+{
+    ThreadStats& stats = threadStats();
+    stats.pending = {};
+    stats.last = {};
+    stats.total = {};
+}
+
+void set_stats_callback(std::function<void(const ParseStats&)> function)
+{
+    std::shared_ptr<const Callback> replacement = function ? std::make_shared<const Callback>(std::move(function)) : nullptr;
+    SharedCallback& shared = callback();
+    const std::lock_guard<std::mutex> lock(shared.mutex);
+    // The old callback is destroyed with `replacement`, once the lock is released.
+    shared.function.swap(replacement);
+}
+
+namespace detail {
+    ParseStats& pending_stats()
+    {
+        return threadStats().pending;
+    }
+
+    void enter_stats()
+    {
+        ++threadStats().depth;
+    }
+
+    void leave_stats()
+    {
+        ThreadStats& stats = threadStats();
+        if (--stats.depth != 0) {
+            return;
+        }
+
+        stats.last = std::exchange(stats.pending, {});
+        stats.total += stats.last;
+        if (const std::shared_ptr<const Callback> function = currentCallback()) {
+            (*function)(stats.last);
+        }
+    }
+}
+
+}
@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "symbols.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    constexpr size_t initial_capacity = 256;
+    constexpr size_t block_size = 4096;
+
+    constexpr uint64_t slotValue(uint32_t symbol, size_t hash)
+    {
+        return (static_cast<uint64_t>(hash) & ~uint64_t(0xffffffff)) | (static_cast<uint64_t>(symbol) + 1);
+    }
+}
+
+SymbolTable::Index::Index(size_t capacity)
+    : mask(capacity - 1), slots(std::make_unique<std::atomic<uint64_t>[]>(capacity))
+{
+}
+
+SymbolTable::SymbolTable()
+    : m_Size(0), m_Index(nullptr), m_Segments{}, m_BlockUsed(0), m_BlockSize(0)
+{
+    m_Indexes.push_back(std::make_unique<Index>(initial_capacity));
+    m_Index.store(m_Indexes.back().get(), std::memory_order_release);
+}
+
+SymbolTable::~SymbolTable()
+{
+    for (auto& segment : m_Segments) {
+        delete[] segment.load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Gives the symbol of `name`, adding it to the table if it is not there yet.
+ * @param name The literal to intern; it is copied into the table.
+ * @return The symbol of `name`.
+ */
+auto SymbolTable::intern(std::string_view name) -> Symbol
+{
+    const size_t hash = std::hash<std::string_view>{}(name);
+    if (const auto symbol = lookup(*m_Index.load(std::memory_order_acquire), name, hash)) {
+        return *symbol;
+    }
+
+    const std::lock_guard lock(m_Mutex);
+
+    // Another writer may have added it in the meantime.
+    Index* index = m_Index.load(std::memory_order_relaxed);
+    if (const auto symbol = lookup(*index, name, hash)) {
+        return *symbol;
+    }
+
+    const size_t count = m_Size.load(std::memory_order_relaxed);
+    if (count >= (size_t(1) << 32) - (size_t(1) << first_segment_bits)) {
+        throw std::length_error("SymbolTable is full");
+    }
+    const Symbol symbol = static_cast<Symbol>(count);
+
+    size_t offset = 0;
+    std::atomic<std::string_view*>& entries = segment(symbol, offset);
+    if (offset == 0) {
+        // The first symbol of a segment is numbered so that its position is the segment size.
+        entries.store(new std::string_view[symbol + (size_t(1) << first_segment_bits)], std::memory_order_release);
+    }
+    entries.load(std::memory_order_relaxed)[offset] = store(name);
+
+    // Kept at most half full; readers still on the old index just miss the newest symbols.
+    if (2 * (count + 1) > index->mask + 1) {
+        auto grown = std::make_unique<Index>(2 * (index->mask + 1));
+        for (Symbol old = 0; old < symbol; ++old) {
+            insert(*grown, old, std::hash<std::string_view>{}(this->name(old)));
+        }
+        index = grown.get();
+        m_Indexes.push_back(std::move(grown));
+        m_Index.store(index, std::memory_order_release);
+    }
+
+    m_Size.store(count + 1, std::memory_order_release);
+    insert(*index, symbol, hash);
+    return symbol;
+}
+
+/**
+ * @brief Looks `name` up without adding it.
+ * @param name The literal to look for.
+ * @return The symbol of `name`, or `std::nullopt` if it was never interned.
+ */
+auto SymbolTable::find(std::string_view name) const -> std::optional<Symbol>
+{
+    return lookup(*m_Index.load(std::memory_order_acquire), name, std::hash<std::string_view>{}(name));
+}
+
+/**
+ * @brief Gives the literal of a symbol.
+ * @param symbol A symbol returned by this table.
+ * @return A view of the stored literal, valid as long as the table.
+ */
+std::string_view SymbolTable::name(Symbol symbol) const
+{
+    if (symbol >= m_Size.load(std::memory_order_acquire)) {
+        throw std::out_of_range("Symbol is not in the table");
+    }
+    size_t offset = 0;
+    return segment(symbol, offset).load(std::memory_order_acquire)[offset];
+}
+
+/**
+ * @brief Gives the number of symbols in the table.
+ */
+size_t SymbolTable::size() const
+{
+    return m_Size.load(std::memory_order_acquire);
+}
+
+auto SymbolTable::lookup(const Index& index, std::string_view name, size_t hash) const -> std::optional<Symbol>
+{
+    const uint64_t tag = slotValue(0, hash) & ~uint64_t(0xffffffff);
+    for (size_t slot = hash & index.mask; ; slot = (slot + 1) & index.mask) {
+        const uint64_t value = index.slots[slot].load(std::memory_order_acquire);
+        if (value == 0) {
+            return std::nullopt;
+        }
+        if ((value & ~uint64_t(0xffffffff)) == tag) {
+            const Symbol symbol = static_cast<Symbol>((value & 0xffffffff) - 1);
+            size_t offset = 0;
+            if (segment(symbol, offset).load(std::memory_order_acquire)[offset] == name) {
+                return symbol;
+            }
+        }
+    }
+}
+
+// Publishes `symbol` in `index`; its name must already be stored.
+void SymbolTable::insert(Index& index, Symbol symbol, size_t hash)
+{
+    size_t slot = hash & index.mask;
+    while (index.slots[slot].load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) & index.mask;
+    }
+    index.slots[slot].store(slotValue(symbol, hash), std::memory_order_release);
+}
+
+// Copies `name` into a block that never moves.
+std::string_view SymbolTable::store(std::string_view name)
+{
+    if (name.empty()) {
+        return {};
+    }
+    if (m_BlockUsed + name.size() > m_BlockSize) {
+        m_BlockSize = std::max(block_size, name.size());
+        m_Blocks.push_back(std::make_unique<char[]>(m_BlockSize));
+        m_BlockUsed = 0;
+    }
+    char* destination = m_Blocks.back().get() + m_BlockUsed;
+    std::memcpy(destination, name.data(), name.size());
+    m_BlockUsed += name.size();
+    return { destination, name.size() };
+}
+
+// Finds the segment holding `symbol`, and its position in it.
+std::atomic<std::string_view*>& SymbolTable::segment(Symbol symbol, size_t& offset)
+{
+    const size_t position = static_cast<size_t>(symbol) + (size_t(1) << first_segment_bits);
+    const size_t bits = std::bit_width(position) - 1;
+    offset = position - (size_t(1) << bits);
+    return m_Segments[bits - first_segment_bits];
+}
+
+const std::atomic<std::string_view*>& SymbolTable::segment(Symbol symbol, size_t& offset) const
+{
+    return const_cast<SymbolTable*>(this)->segment(symbol, offset);
+}
+
+}
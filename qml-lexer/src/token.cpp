@@ -6,6 +6,9 @@
 
 #include "token.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace iif_sadaf::talk::QMLParser {
 
 /**
@@ -17,4 +20,167 @@ Token::Token(std::string literal, TokenType type)
     : literal(std::move(literal)), type(type)
 {}
 
-}
\ No newline at end of file
+/**
+ * @brief Constructs a TokenView.
+ * @param literal A view of the token's text inside the lexed buffer.
+ * @param type The type of the token.
+ */
+TokenView::TokenView(std::string_view literal, TokenType type)
+    : literal(literal), type(type)
+{}
+
+/**
+ * @brief Constructs a TokenBuffer holding a copy of `tokens`.
+ * @param tokens The tokens to copy.
+ */
+TokenBuffer::TokenBuffer(std::span<const Token> tokens)
+{
+    m_Tokens.reserve(tokens.size());
+    for (const Token& token : tokens) {
+        push(token.literal, token.type);
+    }
+}
+
+/**
+ * @brief Constructs a TokenBuffer holding a copy of `tokens`, literals included.
+ * @param tokens The tokens to copy.
+ */
+TokenBuffer::TokenBuffer(std::span<const TokenView> tokens)
+{
+    m_Tokens.reserve(tokens.size());
+    for (const TokenView& token : tokens) {
+        push(token.literal, token.type);
+    }
+}
+
+/**
+ * @brief Appends a token to the buffer.
+ *
+ * The literal is copied only if it differs from the type's `fixed_spelling()`.
+ *
+ * @param literal The textual representation of the token.
+ * @param type The type of the token.
+ * @throws std::length_error If the literal or the buffer outgrow a compact token.
+ */
+void TokenBuffer::push(std::string_view literal, TokenType type)
+{
+    m_Tokens.push_back(store(literal, type));
+}
+
+/**
+ * @brief Appends a copy of some of the tokens of another buffer.
+ * @param tokens The buffer to copy from, which must not be this one.
+ * @param begin The index of the first token to copy.
+ * @param end The index past the last token to copy.
+ * @throws std::length_error If the buffer outgrows a compact token.
+ */
+void TokenBuffer::append(const TokenBuffer& tokens, size_t begin, size_t end)
+{
+    m_Tokens.reserve(m_Tokens.size() + (end - begin));
+    for (size_t i = begin; i < end; ++i) {
+        const CompactToken token = tokens.m_Tokens[i];
+        if (token.offset() == fixed) {
+            m_Tokens.push_back(token);
+        }
+        else {
+            push(tokens.literal(i), token.type());
+        }
+    }
+}
+
+/**
+ * @brief Replaces some of the tokens with a copy of those of another buffer.
+ *
+ * Only the tokens from `end` on are moved, and only if as many tokens are put in as are
+ * taken out. The literals of the tokens taken out are left where they are, and the string
+ * holding them is compacted once they outweigh the rest, so splicing is constant time on
+ * average, plus the tokens moved.
+ *
+ * @param begin The index of the first token to replace.
+ * @param end The index past the last token to replace.
+ * @param tokens The tokens to put in their place, which must not be this buffer.
+ * @throws std::length_error If the buffer outgrows a compact token.
+ */
+void TokenBuffer::replace(size_t begin, size_t end, const TokenBuffer& tokens)
+{
+    for (size_t i = begin; i < end; ++i) {
+        if (m_Tokens[i].offset() != fixed) {
+            m_Garbage += m_Tokens[i].length();
+        }
+    }
+
+    const size_t kept = std::min(end - begin, tokens.size());
+    for (size_t i = 0; i < kept; ++i) {
+        m_Tokens[begin + i] = store(tokens.literal(i), tokens.type(i));
+    }
+    const auto at = m_Tokens.begin() + static_cast<std::ptrdiff_t>(begin + kept);
+    if (kept < end - begin) {
+        m_Tokens.erase(at, m_Tokens.begin() + static_cast<std::ptrdiff_t>(end));
+    }
+    else if (kept < tokens.size()) {
+        std::vector<CompactToken> added;
+        added.reserve(tokens.size() - kept);
+        for (size_t i = kept; i < tokens.size(); ++i) {
+            added.push_back(store(tokens.literal(i), tokens.type(i)));
+        }
+        m_Tokens.insert(at, added.begin(), added.end());
+    }
+
+    // Compacting takes time in the literals and tokens kept, so it waits until the garbage outweighs them.
+    if (m_Garbage > m_Literals.size() - m_Garbage + m_Tokens.size()) {
+        compact();
+    }
+}
+
+/**
+ * @brief Removes every token, keeping the memory for the next ones.
+ */
+void TokenBuffer::clear()
+{
+    m_Tokens.clear();
+    m_Literals.clear();
+    m_Garbage = 0;
+}
+
+// Keeps the literal of a token about to be added, unless it is the spelling of its type.
+CompactToken TokenBuffer::store(std::string_view literal, TokenType type)
+{
+    if (literal == fixed_spelling(type)) {
+        return { type, fixed, 0 };
+    }
+    if (literal.size() > CompactToken::max_length || m_Literals.size() + literal.size() >= fixed) {
+        throw std::length_error("TokenBuffer: literal out of range of a compact token");
+    }
+    const CompactToken token(type, static_cast<uint32_t>(m_Literals.size()), static_cast<uint32_t>(literal.size()));
+    m_Literals.append(literal);
+    return token;
+}
+
+// Drops the literals no token refers to.
+void TokenBuffer::compact()
+{
+    std::string literals;
+    literals.reserve(m_Literals.size() - m_Garbage);
+    for (CompactToken& token : m_Tokens) {
+        if (token.offset() != fixed) {
+            const uint32_t offset = static_cast<uint32_t>(literals.size());
+            literals.append(m_Literals, token.offset(), token.length());
+            token = CompactToken(token.type(), offset, token.length());
+        }
+    }
+    m_Literals = std::move(literals);
+    m_Garbage = 0;
+}
+
+/**
+ * @brief Makes room for tokens and literal bytes, so that pushing them does not allocate.
+ * @param tokens The number of tokens.
+ * @param literals The number of bytes of the literals kept.
+ */
+void TokenBuffer::reserve(size_t tokens, size_t literals)
+{
+    m_Tokens.reserve(tokens);
+    m_Literals.reserve(literals);
+}
+
+}
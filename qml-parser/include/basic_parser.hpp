@@ -0,0 +1,1367 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "builder.hpp"
+#include "error.hpp"
+#include "lexer.hpp"
+#include "maps.hpp"
+#include "stats.hpp"
+#include "teardown.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @enum Rule
+ * @brief Names the rules of the grammar, so that an entry point can be fixed at compile time.
+ *
+ * `DYNAMIC` leaves the choice to run time: the entry point is then the `ParseFunction`
+ * passed to `parse()`.
+ */
+enum class Rule {
+    EQUIVALENCE,
+    IMPLICATION,
+    CONJUNCTION_DISJUNCTION,
+    CLAUSE,
+    QUANTIFICATIONAL,
+    UNARY,
+    ATOMIC,
+    PREDICATION,
+    IDENTITY,
+    INEQUALITY,
+    DYNAMIC
+};
+
+namespace detail {
+    constexpr bool isTerm(TokenType type)
+    {
+        return type == TokenType::VARIABLE || type == TokenType::IDENTIFIER;
+    }
+
+    constexpr bool isUnaryOperator(TokenType type)
+    {
+        return type == TokenType::NOT || type == TokenType::NEC || type == TokenType::POS;
+    }
+
+    constexpr bool isQuantifier(TokenType type)
+    {
+        return type == TokenType::FORALL || type == TokenType::EXISTS || type == TokenType::NOT_EXISTS;
+    }
+
+    // How far up the grammar a connective is: ∧ and ∨, then →, then ↔. -1 for any other token.
+    constexpr int connectiveLevel(TokenType type)
+    {
+        switch (type) {
+        case TokenType::AND:
+        case TokenType::OR: return 0;
+        case TokenType::IF: return 1;
+        case TokenType::EQ: return 2;
+        default: return -1;
+        }
+    }
+
+    // The highest connective an entry rule parses outside brackets. -1 if it parses none.
+    constexpr int connectiveLevel(Rule entry)
+    {
+        switch (entry) {
+        case Rule::CONJUNCTION_DISJUNCTION: return 0;
+        case Rule::IMPLICATION: return 1;
+        case Rule::EQUIVALENCE:
+        case Rule::DYNAMIC: return 2;
+        default: return -1;
+        }
+    }
+
+    struct NoEntryPoint {};
+
+    // A builder that wants to know which tokens each node it builds covers (see `SpanBuilder`).
+    template<typename Builder>
+    concept TracksSpans = requires(const Builder& builder, size_t index) { builder.span(index, index); };
+
+    // Stands for a token index where no span is tracked, and forgets any it is given.
+    struct NoSpan {
+        NoSpan() = default;
+        constexpr NoSpan(size_t) {}
+    };
+}
+
+/**
+ * @class ParserBase
+ * @brief Holds the token stream that every `BasicParser` reads from.
+ *
+ * The tokens come either from a `TokenBuffer`, owned by the parser or by the caller, or
+ * straight from a `Lexer`. None of this depends on the mapping or the entry rule, so it is
+ * shared by all instantiations of `BasicParser`. A copy of a parser reads a copy of the
+ * tokens it owns, and otherwise the same buffer as the original. A parser that pulls its
+ * tokens from a `Lexer` must not be copied: the copy would drive the same lexer, so that
+ * each would consume the tokens of the other. Such a parser can be moved, which leaves the
+ * source with no tokens, or copied once `reset()` has given it tokens of its own.
+ */
+class ParserBase
+{
+public:
+    ParserBase(const ParserBase& other);
+    ParserBase& operator=(const ParserBase& other);
+    ParserBase(ParserBase&& other) noexcept;
+    ParserBase& operator=(ParserBase&& other) noexcept;
+
+    void reset(std::string_view formula);
+    void setNestingLimit(size_t limit);
+
+    /// The nesting limit of a parser that was not given one: deep enough for any formula
+    /// written by hand, and shallow enough that its tree is destroyed recursively in some
+    /// 70 KiB of stack in an optimized build (see `parse()`).
+    static constexpr size_t default_nesting_limit = 1000;
+
+protected:
+    struct Checkpoint {
+        int index;
+        size_t offset;
+    };
+
+    ParserBase();
+    explicit ParserBase(const std::vector<Token>& tokens);
+    explicit ParserBase(std::span<const Token> tokens);
+    explicit ParserBase(const std::vector<TokenView>& tokens);
+    explicit ParserBase(const TokenBuffer& tokens);
+    explicit ParserBase(TokenBuffer&& tokens);
+    explicit ParserBase(Lexer& lexer);
+    ~ParserBase() = default;
+
+    bool rewind();
+    void advance();
+    TokenType peek(int offset = 0) const;
+    TokenView getToken(size_t index) const;
+    size_t countArguments() const;
+    Checkpoint mark() const;
+    void restore(Checkpoint checkpoint);
+
+    int m_Index;
+    TokenType m_LookAhead;
+    size_t m_NestingLimit = default_nesting_limit;
+
+private:
+    void start();
+
+    TokenBuffer m_OwnedTokens;
+    // The tokens read: m_OwnedTokens, or a buffer of the caller's.
+    const TokenBuffer* m_Tokens = &m_OwnedTokens;
+    Lexer* m_Lexer = nullptr;
+};
+
+/**
+ * @class BasicParser
+ * @brief Parses a sequence of tokens into a Quantified Modal Logic (QML) expression tree.
+ *
+ * This class implements a recursive descent parser for QML expressions. The rules that can
+ * nest (connectives, prefix operators, quantifiers and brackets) do not call each other,
+ * though: they run on an explicit stack of frames, so however deeply a formula nests, the
+ * native stack stays flat. Past the nesting limit (see `setNestingLimit()`), a parse fails
+ * with `ErrorCode::NESTING_TOO_DEEP` instead. `Mapping` maps token
+ * types to operators; with one of the functors in maps.hpp, every call to it is resolved,
+ * and usually inlined, at compile time. `Entry` is the rule parsing starts from, and the
+ * rule parenthesized subformulas are parsed with. `Parser` is the instantiation that picks
+ * both at run time, through `std::function`.
+ *
+ * `Error` is what a failed parse returns: a `std::string` message, a `ParseError` that is
+ * only formatted on request, or a `Rejection` that carries nothing (see error.hpp).
+ * `Builder` is what the parser makes of what it recognizes: the expression tree, by default,
+ * or nothing at all with `NullBuilder` (see builder.hpp).
+ */
+template<typename Mapping, Rule Entry = Rule::DYNAMIC, typename Error = std::string, typename Builder = ExpressionBuilder>
+class BasicParser : public ParserBase
+{
+public:
+    using Value = typename Builder::Value;
+    using TermValue = typename Builder::TermValue;
+    using Arguments = typename Builder::Arguments;
+    using Result = std::expected<Value, Error>;
+
+    /**
+     * @typedef ParseFunction
+     * @brief Defines the function signature for parsing rules.
+     */
+    using ParseFunction = std::function<Result(BasicParser&)>;
+
+    /**
+     * @typedef MappingFunction
+     * @brief Maps token types to QML logical operators.
+     */
+    using MappingFunction = std::function<std::optional<QMLExpression::Operator>(TokenType)>;
+
+    /**
+     * @struct Group
+     * @brief A clause parsed before: how many tokens it takes, how many levels it nests, and its value.
+     */
+    struct Group {
+        size_t length = 0;
+        size_t depth = 0;
+        std::optional<Value> value = {};
+    };
+
+    /**
+     * @struct Prefix
+     * @brief Where a parse can be taken up again: just past a connective outside of every
+     * bracket, with the connectives still waiting for their right-hand side.
+     */
+    struct Prefix;
+
+    /// How many tokens apart prefixes are recorded (see `setPrefixes()`).
+    static constexpr size_t prefix_spacing = 32;
+
+    explicit BasicParser(Mapping mapping = defaultMapping(), Builder builder = Builder());
+    BasicParser(const std::vector<Token>& tokens, Mapping mapping = defaultMapping(), Builder builder = Builder());
+    BasicParser(std::span<const Token> tokens, Mapping mapping = defaultMapping(), Builder builder = Builder());
+    BasicParser(const std::vector<TokenView>& tokens, Mapping mapping = defaultMapping(), Builder builder = Builder());
+    BasicParser(const TokenBuffer& tokens, Mapping mapping = defaultMapping(), Builder builder = Builder());
+    BasicParser(TokenBuffer&& tokens, Mapping mapping = defaultMapping(), Builder builder = Builder());
+    BasicParser(Lexer& lexer, Mapping mapping = defaultMapping(), Builder builder = Builder());
+
+    Result parse() requires (Entry != Rule::DYNAMIC);
+    Result parse(ParseFunction entryPoint = &BasicParser::equivalence) requires (Entry == Rule::DYNAMIC);
+
+    static ParseFunction entryPointFor(Rule rule);
+
+    Builder& builder();
+    void setGroups(std::vector<Group>* groups);
+    void setPrefixes(std::vector<Prefix>* prefixes);
+    void setMemoryResource(std::pmr::memory_resource* resource) requires std::is_same_v<Builder, ExpressionBuilder>;
+
+    // rules
+    Result equivalence();
+    Result implication();
+    Result conjunction_disjunction();
+    Result clause();
+    Result quantificational();
+    Result unary();
+    Result atomic();
+    Result predication();
+    Result identity();
+    Result inequality();
+
+private:
+    using SpanStart = std::conditional_t<detail::TracksSpans<Builder>, size_t, detail::NoSpan>;
+
+    // A rule left halfway, waiting for the result of the rule it descended into.
+    struct Frame {
+        // The rule waiting: a binary connective level, a prefix, or CLAUSE for a bracket.
+        Rule rule = Rule::DYNAMIC;
+        // The connective, the prefix operator, or the closing bracket.
+        TokenType token = TokenType::NIL;
+        QMLExpression::Operator op{};
+        QMLExpression::Quantifier quantifier{};
+        bool negated = false;
+        // The opening bracket, and its index.
+        std::string_view literal = {};
+        size_t open = 0;
+        // The left-hand side of a connective level, once parsed.
+        std::optional<Value> lhs = {};
+        // Where the node of a connective level or a prefix begins, if the builder asks.
+        [[no_unique_address]] SpanStart begin{};
+        // The deepest nesting reached outside of a bracket or prefix, while it is open.
+        size_t peak = 0;
+    };
+
+    // The frames of the rules left halfway, and the variables of their quantifiers.
+    struct Stack {
+        std::vector<Frame> frames;
+        std::vector<TermValue> variables;
+    };
+
+    static Mapping defaultMapping();
+    static Rule ruleOf(const ParseFunction& entryPoint);
+
+    static Stack& stack();
+    Result run(Rule rule);
+    Result descend(Stack& stack, Rule rule, bool& overflow);
+    std::optional<Rule> ascend(Stack& stack, Result& result);
+    bool nest();
+    size_t unnest(const Frame& frame);
+    void remember(size_t start, size_t depth, const Value& value);
+    void unwind(Stack& stack, size_t base);
+    void built(SpanStart begin) const;
+    static void drop(Value&& value);
+    static void pop(Stack& stack);
+
+    Result enter();
+    ParseError errorAt(ErrorCode code, size_t index, std::string_view context = {}, TokenType expected = TokenType::NIL) const;
+    static std::unexpected<Error> reject(ParseError&& error);
+    static std::unexpected<Error> wrap(Error&& error, TokenType op);
+
+    // start rule
+    Result sentence();
+
+    [[no_unique_address]] Mapping m_Mapping;
+    [[no_unique_address]] Builder m_Builder;
+    [[no_unique_address]] std::conditional_t<Entry == Rule::DYNAMIC, ParseFunction, detail::NoEntryPoint> m_EntryPoint{};
+    // The rule brackets are parsed with; DYNAMIC when only m_EntryPoint knows.
+    Rule m_EntryRule = Entry;
+    // The number of prefixes and brackets with a frame on the stack.
+    size_t m_Depth = 0;
+    // The deepest m_Depth reached since the innermost of them opened.
+    size_t m_Peak = 0;
+    std::vector<Group>* m_Groups = nullptr;
+    std::vector<Prefix>* m_Prefixes = nullptr;
+};
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+struct BasicParser<Mapping, Entry, Error, Builder>::Prefix {
+    /// The index of the token after the connective.
+    size_t index = 0;
+    /// The rule the parse started from, and the one it goes on with from `index`.
+    Rule entry = Rule::DYNAMIC;
+    Rule next = Rule::DYNAMIC;
+    /// The deepest nesting of the tokens before `index`.
+    size_t depth = 0;
+    /// The connectives waiting, outermost first.
+    std::vector<Frame> frames = {};
+};
+
+inline void ParserBase::advance()
+{
+    if (m_LookAhead != TokenType::EOI) {
+        m_Index++;
+        if (m_Lexer != nullptr) {
+            m_Lexer->next();
+            m_LookAhead = m_Lexer->peek().type;
+        }
+        else {
+            m_LookAhead = m_Tokens->type(m_Index);
+        }
+    }
+}
+
+inline TokenType ParserBase::peek(int offset) const
+{
+    if (m_Lexer != nullptr) {
+        return m_Lexer->peek(offset).type;
+    }
+    if (m_Index + offset < m_Tokens->size()) {
+        return m_Tokens->type(m_Index + offset);
+    }
+    return TokenType::EOI;
+}
+
+inline TokenView ParserBase::getToken(size_t index) const {
+    if (m_Lexer != nullptr) {
+        return m_Lexer->peek(index - m_Index);
+    }
+    if (index < m_Tokens->size()) {
+        return (*m_Tokens)[index];
+    }
+    return (*m_Tokens)[m_Tokens->size() - 1];
+}
+
+// Counts the terms of the argument list that starts at the current token, so that it can
+// be allocated at once. A lexer cannot look that far ahead, so it is taken to have none.
+inline size_t ParserBase::countArguments() const
+{
+    if (m_Lexer != nullptr) {
+        return 0;
+    }
+    size_t count = 0;
+    for (size_t i = m_Index; i < m_Tokens->size() && detail::isTerm(m_Tokens->type(i)); i += 2) {
+        ++count;
+        if (i + 1 >= m_Tokens->size() || m_Tokens->type(i + 1) != TokenType::COMMA) {
+            break;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Provides the mapping used when none is given.
+ *
+ * A `Mapping` that can hold a function pointer, such as `MappingFunction`, defaults to
+ * `mapToAlethicOperator`; any other is default-constructed.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+Mapping BasicParser<Mapping, Entry, Error, Builder>::defaultMapping()
+{
+    if constexpr (std::is_constructible_v<Mapping, decltype(&mapToAlethicOperator)>) {
+        return Mapping(&mapToAlethicOperator);
+    }
+    else {
+        return Mapping{};
+    }
+}
+
+/**
+ * @brief Constructs a BasicParser instance with nothing to parse yet.
+ *
+ * Meant to be kept around and given one formula after another through `reset()`.
+ *
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(Mapping mapping, Builder builder)
+    : ParserBase(), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Constructs a BasicParser instance.
+ *
+ * The tokens are copied into a compact buffer the parser owns (see `TokenBuffer`), of which
+ * only the literals of identifiers, variables and illegal tokens are kept, so `tokens` need
+ * not outlive the call. A buffer of that kind cannot take over the strings of a `Token`, so
+ * a temporary list, such as the one `lex()` returns, is copied the same way.
+ *
+ * @param tokens The list of tokens to parse.
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(const std::vector<Token>& tokens, Mapping mapping, Builder builder)
+    : ParserBase(tokens), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Constructs a BasicParser instance over a copy of tokens owned by the caller.
+ *
+ * The tokens are copied into a compact buffer the parser owns, so `tokens` need not
+ * outlive the call.
+ *
+ * @param tokens The list of tokens to parse.
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(std::span<const Token> tokens, Mapping mapping, Builder builder)
+    : ParserBase(tokens), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Constructs a BasicParser instance over a copy of non-owning tokens.
+ *
+ * The tokens are copied into a compact buffer the parser owns, literals included, so the
+ * buffer they were lexed from (see `lex_view()`) need not outlive the call.
+ *
+ * @param tokens The list of tokens to parse.
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(const std::vector<TokenView>& tokens, Mapping mapping, Builder builder)
+    : ParserBase(tokens), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Constructs a BasicParser instance over a token buffer owned by the caller.
+ *
+ * Nothing is copied, so `tokens` must outlive the parser and every call to `parse()`, and
+ * must not change in between.
+ *
+ * @param tokens The tokens to parse, as filled by `lex()`.
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(const TokenBuffer& tokens, Mapping mapping, Builder builder)
+    : ParserBase(tokens), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Constructs a BasicParser instance that takes over a token buffer.
+ * @param tokens The tokens to parse, as filled by `lex()`.
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(TokenBuffer&& tokens, Mapping mapping, Builder builder)
+    : ParserBase(std::move(tokens)), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Constructs a BasicParser instance that pulls its tokens from `lexer`.
+ *
+ * No token list is built: the parser asks the lexer for each token as it goes, so memory
+ * stays flat however long the formula is. The lexer, and the buffer it reads from, must
+ * outlive the parser, and a call to `parse()` consumes the tokens it reads.
+ *
+ * @param lexer The source of the tokens to parse.
+ * @param mapping Maps tokens to modal operators (default: alethic logic).
+ * @param builder Makes the result out of what is parsed (default: the expression tree).
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+BasicParser<Mapping, Entry, Error, Builder>::BasicParser(Lexer& lexer, Mapping mapping, Builder builder)
+    : ParserBase(lexer), m_Mapping(std::move(mapping)), m_Builder(std::move(builder))
+{
+}
+
+/**
+ * @brief Parses the token stream into a QML expression, starting from `Entry`.
+ *
+ * Parsing takes no native stack per level of nesting, but destroying the expression tree
+ * returned does, one call per level: about 70 bytes per level in an optimized build for a
+ * quantifier, the costliest node, and several times that without optimization. A tree as
+ * deep as the default nesting limit allows thus takes some 70 KiB of stack to destroy. On
+ * threads with less, hold the result in an `OwnedExpression`, which destroys it without
+ * recursing.
+ *
+ * @return Parsed QML expression or an error message.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::parse() -> Result requires (Entry != Rule::DYNAMIC)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::parse_time);
+
+    if (!rewind()) {
+        return reject({ .code = ErrorCode::EMPTY_INPUT });
+    }
+
+    m_Depth = 0;
+    m_Peak = 0;
+
+    return sentence();
+}
+
+/**
+ * @brief Parses the token stream into a QML expression.
+ *
+ * As the overload for a fixed `Entry`, destroying the tree returned takes native stack per
+ * level: some 70 KiB for a tree as deep as the default nesting limit allows, in an optimized
+ * build. On threads with less, hold the result in an `OwnedExpression`.
+ *
+ * @param entryPoint The starting parse rule (default: equivalence).
+ * @return Parsed QML expression or an error message.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::parse(ParseFunction entryPoint) -> Result requires (Entry == Rule::DYNAMIC)
+{
+    const detail::StatsScope scope;
+    const detail::StatsTimer timer(&ParseStats::parse_time);
+
+    const bool has_tokens = rewind();
+
+    m_EntryRule = ruleOf(entryPoint);
+    m_EntryPoint = std::move(entryPoint);
+
+    if (!has_tokens) {
+        return reject({ .code = ErrorCode::EMPTY_INPUT });
+    }
+
+    m_Depth = 0;
+    m_Peak = 0;
+
+    return sentence();
+}
+
+/**
+ * @brief Gives the rule of this parser named by `rule`, for use as an entry point.
+ * @param rule The rule to start from; `Rule::DYNAMIC` stands for `Rule::EQUIVALENCE`.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::entryPointFor(Rule rule) -> ParseFunction
+{
+    switch (rule) {
+    case Rule::IMPLICATION: return &BasicParser::implication;
+    case Rule::CONJUNCTION_DISJUNCTION: return &BasicParser::conjunction_disjunction;
+    case Rule::CLAUSE: return &BasicParser::clause;
+    case Rule::QUANTIFICATIONAL: return &BasicParser::quantificational;
+    case Rule::UNARY: return &BasicParser::unary;
+    case Rule::ATOMIC: return &BasicParser::atomic;
+    case Rule::PREDICATION: return &BasicParser::predication;
+    case Rule::IDENTITY: return &BasicParser::identity;
+    case Rule::INEQUALITY: return &BasicParser::inequality;
+    default: return &BasicParser::equivalence;
+    }
+}
+
+/**
+ * @brief Lets clauses parsed before be skipped.
+ *
+ * Once set, every clause that parses, be it atomic, a prefix or quantifier and what it
+ * applies to, or a bracketed subformula, is recorded in `groups`, at the index of its first
+ * token. When a clause is reached whose entry holds a value, that value is taken as the
+ * result of the whole clause, and parsing resumes after its last token. What a clause parses
+ * to only depends on its own tokens, so the entries stay valid as long as those tokens, the
+ * entry rule and the mapping do not change. An entry is only taken if the levels it nests,
+ * added to those already open, stay within the nesting limit; otherwise the clause is parsed
+ * again, and fails as it would have.
+ *
+ * Only for parsers that read a token list, with `groups` holding an entry for every token.
+ *
+ * @param groups The recorded clauses, or `nullptr` to parse every clause.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::setGroups(std::vector<Group>* groups)
+{
+    m_Groups = groups;
+}
+
+/**
+ * @brief Lets a parse be taken up again past the connectives parsed before.
+ *
+ * Once set, a prefix is appended to `prefixes` after a connective outside of every bracket,
+ * every `prefix_spacing` tokens or so, holding the connectives waiting for their right-hand
+ * side. A parse from one of the rules of the parser starts from the last prefix in the list
+ * instead of the first token, if that prefix was recorded from the same rule. What the
+ * tokens before a prefix parse to only depends on them, so the caller must drop the
+ * prefixes past the first token it changes, and keep the others in order.
+ *
+ * Only for parsers that read a token list.
+ *
+ * @param prefixes The recorded prefixes, or `nullptr` to always start from the first token.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::setPrefixes(std::vector<Prefix>* prefixes)
+{
+    m_Prefixes = prefixes;
+}
+
+// Gives access to the builder, for builders that keep state across parses.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+Builder& BasicParser<Mapping, Entry, Error, Builder>::builder()
+{
+    return m_Builder;
+}
+
+/**
+ * @brief Selects where the nodes of the expression tree are allocated.
+ * @param resource The memory resource to allocate nodes from, or `nullptr` for the heap.
+ * @see ExpressionBuilder::setMemoryResource()
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::setMemoryResource(std::pmr::memory_resource* resource) requires std::is_same_v<Builder, ExpressionBuilder>
+{
+    m_Builder.setMemoryResource(resource);
+}
+
+/**
+ * @brief Tells which rule an entry point is, if it is one of the rules of this parser.
+ * @return The rule, or `Rule::DYNAMIC` for any other function.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+Rule BasicParser<Mapping, Entry, Error, Builder>::ruleOf(const ParseFunction& entryPoint)
+{
+    using Method = Result (BasicParser::*)();
+    static constexpr std::pair<Method, Rule> rules[] = {
+        { &BasicParser::equivalence, Rule::EQUIVALENCE },
+        { &BasicParser::implication, Rule::IMPLICATION },
+        { &BasicParser::conjunction_disjunction, Rule::CONJUNCTION_DISJUNCTION },
+        { &BasicParser::clause, Rule::CLAUSE },
+        { &BasicParser::quantificational, Rule::QUANTIFICATIONAL },
+        { &BasicParser::unary, Rule::UNARY },
+        { &BasicParser::atomic, Rule::ATOMIC },
+        { &BasicParser::predication, Rule::PREDICATION },
+        { &BasicParser::identity, Rule::IDENTITY },
+        { &BasicParser::inequality, Rule::INEQUALITY },
+    };
+
+    if (const Method* method = entryPoint.template target<Method>()) {
+        for (const auto& [candidate, rule] : rules) {
+            if (*method == candidate) {
+                return rule;
+            }
+        }
+    }
+    return Rule::DYNAMIC;
+}
+
+/**
+ * @brief Provides the frame stack of the calling thread.
+ *
+ * It is shared by every parser of this type on the thread, so that its storage is reused
+ * from one parser to the next. Calls to `run()` nest strictly on a thread, and each one
+ * only touches the frames above those it found.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::stack() -> Stack&
+{
+    static thread_local Stack frames;
+    return frames;
+}
+
+/**
+ * @brief Parses `rule` on the explicit stack.
+ *
+ * Descends from `rule` to the first leaf, leaving a frame for every rule it passes through,
+ * then hands the result back up the frames until one of them needs another operand, and
+ * descends from there. A bracket parsed with an entry point that is not one of the rules
+ * calls that entry point, which may start another run on top of this one.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::run(Rule rule) -> Result
+{
+    Stack& frames = stack();
+    const size_t base = frames.frames.size();
+    const Rule entry = rule;
+
+    // Leaves the stack as it was found, even if the builder or the mapping throws.
+    struct Unwind {
+        BasicParser& parser;
+        Stack& stack;
+        size_t base;
+        ~Unwind() { parser.unwind(stack, base); }
+    } unwind{ *this, frames, base };
+
+    // A parse from the first token may start from the last prefix instead.
+    if (m_Prefixes != nullptr && !m_Prefixes->empty() && m_Index == 0 && m_Depth == 0) {
+        if (const Prefix& prefix = m_Prefixes->back(); prefix.entry == entry) {
+            frames.frames.insert(frames.frames.end(), prefix.frames.begin(), prefix.frames.end());
+            restore({ static_cast<int>(prefix.index), 0 });
+            m_Peak = prefix.depth;
+            detail::record_depth(prefix.depth);
+            rule = prefix.next;
+        }
+    }
+
+    for (;;) {
+        bool overflow = false;
+        Result result = descend(frames, rule, overflow);
+
+        if (overflow) {
+            return result;
+        }
+
+        std::optional<Rule> next;
+        while (!next.has_value() && frames.frames.size() > base) {
+            next = ascend(frames, result);
+        }
+
+        if (!next.has_value()) {
+            return result;
+        }
+        rule = *next;
+
+        // Outside of every bracket, only the connectives waiting are on the stack.
+        if (m_Prefixes != nullptr && m_Depth == 0 && (m_Prefixes->empty() || static_cast<size_t>(m_Index) >= m_Prefixes->back().index + prefix_spacing)) {
+            m_Prefixes->push_back({ .index = static_cast<size_t>(m_Index), .entry = entry, .next = rule, .depth = m_Peak, .frames = { frames.frames.begin() + static_cast<std::ptrdiff_t>(base), frames.frames.end() } });
+        }
+    }
+}
+
+// Pushes frames from `rule` down to a leaf rule, and returns what the leaf returns.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::descend(Stack& stack, Rule rule, bool& overflow) -> Result
+{
+    for (;;) {
+        switch (rule) {
+        case Rule::EQUIVALENCE:
+            stack.frames.push_back({ .rule = Rule::EQUIVALENCE, .token = TokenType::EQ, .begin = static_cast<size_t>(m_Index) });
+            rule = Rule::IMPLICATION;
+            break;
+
+        case Rule::IMPLICATION:
+            stack.frames.push_back({ .rule = Rule::IMPLICATION, .token = TokenType::IF, .begin = static_cast<size_t>(m_Index) });
+            rule = Rule::CONJUNCTION_DISJUNCTION;
+            break;
+
+        case Rule::CONJUNCTION_DISJUNCTION:
+            stack.frames.push_back({ .rule = Rule::CONJUNCTION_DISJUNCTION, .begin = static_cast<size_t>(m_Index) });
+            rule = Rule::CLAUSE;
+            break;
+
+        case Rule::CLAUSE: {
+            if (m_Groups != nullptr) {
+                if (const Group& group = (*m_Groups)[m_Index]; group.value.has_value() && m_Depth + group.depth <= m_NestingLimit) {
+                    m_Peak = std::max(m_Peak, m_Depth + group.depth);
+                    detail::record_depth(m_Depth + group.depth);
+                    restore({ static_cast<int>(static_cast<size_t>(m_Index) + group.length), 0 });
+                    return *group.value;
+                }
+            }
+
+            // Only the type decides; the literal is only looked at for a bracket.
+            const TokenType current = peek();
+
+            if (detail::isTerm(current)) {
+                if (m_Groups == nullptr) {
+                    return atomic();
+                }
+                const size_t start = static_cast<size_t>(m_Index);
+                Result result = atomic();
+                if (result.has_value()) {
+                    remember(start, 0, result.value());
+                }
+                return result;
+            }
+
+            if (detail::isUnaryOperator(current)) {
+                rule = Rule::UNARY;
+                break;
+            }
+
+            if (detail::isQuantifier(current)) {
+                rule = Rule::QUANTIFICATIONAL;
+                break;
+            }
+
+            if (current == TokenType::LPAREN || current == TokenType::LBRACKET) {
+                if (!nest()) {
+                    overflow = true;
+                    return reject(errorAt(ErrorCode::NESTING_TOO_DEEP, m_Index));
+                }
+                const TokenType closing = current == TokenType::LPAREN ? TokenType::RPAREN : TokenType::RBRACKET;
+                const std::string_view opening = getToken(m_Index).literal;
+                advance();
+                stack.frames.push_back({ .rule = Rule::CLAUSE, .token = closing, .literal = opening, .open = static_cast<size_t>(m_Index - 1), .peak = std::exchange(m_Peak, m_Depth) });
+                if (m_EntryRule == Rule::DYNAMIC) {
+                    return enter();
+                }
+                rule = m_EntryRule;
+                break;
+            }
+
+            return reject(errorAt(ErrorCode::UNEXPECTED_TOKEN, m_Index));
+        }
+
+        case Rule::QUANTIFICATIONAL: {
+            if (!detail::isQuantifier(peek())) {
+                return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+            }
+
+            if (peek(1) != TokenType::VARIABLE) {
+                return reject(errorAt(ErrorCode::EXPECTED_VARIABLE, m_Index + 1, getToken(m_Index).literal, TokenType::VARIABLE));
+            }
+
+            if (!nest()) {
+                overflow = true;
+                return reject(errorAt(ErrorCode::NESTING_TOO_DEEP, m_Index));
+            }
+
+            Frame frame{ .rule = Rule::QUANTIFICATIONAL, .open = static_cast<size_t>(m_Index), .peak = std::exchange(m_Peak, m_Depth) };
+            frame.quantifier = peek() == TokenType::FORALL ? QMLExpression::Quantifier::UNIVERSAL : QMLExpression::Quantifier::EXISTENTIAL;
+            frame.negated = peek() == TokenType::NOT_EXISTS;
+
+            advance(); // consume quantifier
+
+            stack.variables.push_back(m_Builder.term(getToken(m_Index).literal, TokenType::VARIABLE));
+
+            advance(); // consume variable
+
+            frame.begin = static_cast<size_t>(m_Index - 2);
+            stack.frames.push_back(std::move(frame));
+            rule = Rule::CLAUSE;
+            break;
+        }
+
+        case Rule::UNARY: {
+            if (!detail::isUnaryOperator(peek())) {
+                return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+            }
+
+            const TokenType unaryOperator = peek();
+            const auto op = m_Mapping(unaryOperator);
+
+            if (!op.has_value()) {
+                return reject({ .code = ErrorCode::MISSING_UNARY_MAP, .index = static_cast<size_t>(m_Index), .actual = unaryOperator });
+            }
+
+            if (!nest()) {
+                overflow = true;
+                return reject(errorAt(ErrorCode::NESTING_TOO_DEEP, m_Index));
+            }
+
+            advance(); // consume operator
+
+            stack.frames.push_back({ .rule = Rule::UNARY, .token = unaryOperator, .op = *op, .open = static_cast<size_t>(m_Index - 1), .begin = static_cast<size_t>(m_Index - 1), .peak = std::exchange(m_Peak, m_Depth) });
+            rule = Rule::CLAUSE;
+            break;
+        }
+
+        case Rule::ATOMIC:
+            return atomic();
+        case Rule::PREDICATION:
+            return predication();
+        case Rule::IDENTITY:
+            return identity();
+        case Rule::INEQUALITY:
+            return inequality();
+        case Rule::DYNAMIC:
+            return enter();
+        }
+    }
+}
+
+/**
+ * @brief Hands `result` to the innermost frame.
+ * @return The rule to parse next, if the frame needs another operand; otherwise the frame
+ * is popped and `result` is what it returns.
+ */
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::ascend(Stack& stack, Result& result) -> std::optional<Rule>
+{
+    Frame& frame = stack.frames.back();
+
+    switch (frame.rule) {
+    case Rule::EQUIVALENCE:
+    case Rule::IMPLICATION:
+    case Rule::CONJUNCTION_DISJUNCTION: {
+        if (!frame.lhs.has_value()) {
+            if (!result.has_value()) {
+                stack.frames.pop_back();
+                return std::nullopt;
+            }
+            frame.lhs.emplace(std::move(result).value());
+        }
+        else {
+            if (!result.has_value()) {
+                const TokenType connective = frame.token;
+                pop(stack);
+                result = wrap(std::move(result).error(), connective);
+                return std::nullopt;
+            }
+            if (frame.rule != Rule::CONJUNCTION_DISJUNCTION) {
+                // The operator of '↔' and '→' is looked up once their right-hand side is parsed.
+                if (const auto op = m_Mapping(frame.token)) {
+                    frame.op = *op;
+                }
+                else {
+                    const TokenType connective = frame.token;
+                    drop(std::move(result).value());
+                    pop(stack);
+                    result = reject({ .code = ErrorCode::MISSING_MAP, .index = static_cast<size_t>(m_Index), .actual = connective });
+                    return std::nullopt;
+                }
+            }
+            frame.lhs.emplace(m_Builder.binary(frame.op, std::move(*frame.lhs), std::move(result).value()));
+            built(frame.begin);
+        }
+
+        if (frame.rule == Rule::CONJUNCTION_DISJUNCTION) {
+            if (peek() == TokenType::OR || peek() == TokenType::AND) {
+                const TokenType connective = peek();
+                const auto op = m_Mapping(connective);
+
+                if (!op.has_value()) {
+                    pop(stack);
+                    result = reject({ .code = ErrorCode::MISSING_MAP, .index = static_cast<size_t>(m_Index), .actual = connective });
+                    return std::nullopt;
+                }
+
+                advance(); // consume operator
+                frame.token = connective;
+                frame.op = *op;
+                return Rule::CLAUSE;
+            }
+        }
+        else if (peek() == frame.token) {
+            advance(); // consume connective
+            return frame.rule == Rule::EQUIVALENCE ? Rule::IMPLICATION : Rule::CONJUNCTION_DISJUNCTION;
+        }
+
+        result = std::move(*frame.lhs);
+        stack.frames.pop_back();
+        return std::nullopt;
+    }
+
+    case Rule::CLAUSE: {
+        const size_t depth = unnest(frame);
+        if (result.has_value() && peek() != frame.token) {
+            drop(std::move(result).value());
+            result = reject(errorAt(ErrorCode::EXPECTED_CLOSING, m_Index, frame.literal, frame.token));
+        }
+        else if (result.has_value()) {
+            advance();
+            remember(frame.open, depth, result.value());
+        }
+        stack.frames.pop_back();
+        return std::nullopt;
+    }
+
+    case Rule::QUANTIFICATIONAL: {
+        const size_t depth = unnest(frame);
+        if (result.has_value()) {
+            Value quantified = m_Builder.quantification(frame.quantifier, std::move(stack.variables.back()), std::move(result).value());
+            built(frame.begin);
+            if (!frame.negated) {
+                result = std::move(quantified);
+            }
+            else if (const auto op = m_Mapping(TokenType::NOT)) {
+                result = m_Builder.unary(*op, std::move(quantified));
+                built(frame.begin);
+            }
+            else {
+                drop(std::move(quantified));
+                result = reject({ .code = ErrorCode::MISSING_MAP, .index = static_cast<size_t>(m_Index), .actual = TokenType::NOT });
+            }
+        }
+        if (result.has_value()) {
+            remember(frame.open, depth, result.value());
+        }
+        stack.variables.pop_back();
+        stack.frames.pop_back();
+        return std::nullopt;
+    }
+
+    default: { // Rule::UNARY
+        const size_t depth = unnest(frame);
+        if (result.has_value()) {
+            result = m_Builder.unary(frame.op, std::move(result).value());
+            built(frame.begin);
+            remember(frame.open, depth, result.value());
+        }
+        else {
+            result = reject({ .code = ErrorCode::EXPECTED_CLAUSE, .index = static_cast<size_t>(m_Index), .actual = frame.token });
+        }
+        stack.frames.pop_back();
+        return std::nullopt;
+    }
+    }
+}
+
+// Counts one more prefix or bracket, unless that would exceed the nesting limit.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+bool BasicParser<Mapping, Entry, Error, Builder>::nest()
+{
+    if (m_Depth >= m_NestingLimit) {
+        return false;
+    }
+    ++m_Depth;
+    detail::record_depth(m_Depth);
+    return true;
+}
+
+// Closes the bracket or prefix of `frame`, and gives the levels it nested, itself included.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+size_t BasicParser<Mapping, Entry, Error, Builder>::unnest(const Frame& frame)
+{
+    --m_Depth;
+    const size_t depth = m_Peak - m_Depth;
+    m_Peak = std::max(m_Peak, frame.peak);
+    return depth;
+}
+
+// Records the clause parsed from `start` up to the current token, if asked to (see `setGroups()`).
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::remember(size_t start, size_t depth, const Value& value)
+{
+    if (m_Groups != nullptr) {
+        (*m_Groups)[start] = { .length = static_cast<size_t>(m_Index) - start, .depth = depth, .value = value };
+    }
+}
+
+// Tells a builder that tracks spans that the node it just built covers the tokens from `begin` up to the current one.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::built([[maybe_unused]] SpanStart begin) const
+{
+    if constexpr (detail::TracksSpans<Builder>) {
+        m_Builder.span(begin, static_cast<size_t>(m_Index));
+    }
+}
+
+// Drops the frames above `base`, abandoning the rules they belong to.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::unwind(Stack& stack, size_t base)
+{
+    while (stack.frames.size() > base) {
+        const Rule rule = stack.frames.back().rule;
+        if (rule == Rule::CLAUSE || rule == Rule::QUANTIFICATIONAL || rule == Rule::UNARY) {
+            --m_Depth;
+        }
+        if (rule == Rule::QUANTIFICATIONAL) {
+            stack.variables.pop_back();
+        }
+        pop(stack);
+    }
+}
+
+// Lets go of a value the parse gave up on, without recursing down a deep expression tree (see `dismantle()`).
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::drop([[maybe_unused]] Value&& value)
+{
+    if constexpr (std::is_same_v<Value, QMLExpression::Expression>) {
+        dismantle(std::move(value));
+    }
+}
+
+// Pops the innermost frame, dropping the left-hand side it holds.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+void BasicParser<Mapping, Entry, Error, Builder>::pop(Stack& stack)
+{
+    if (std::optional<Value>& lhs = stack.frames.back().lhs; lhs.has_value()) {
+        drop(std::move(*lhs));
+    }
+    stack.frames.pop_back();
+}
+
+// Parses with the entry rule, both at the start and inside parentheses and brackets.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::enter() -> Result
+{
+    if constexpr (Entry == Rule::DYNAMIC) {
+        return m_EntryPoint(*this);
+    }
+    else if constexpr (Entry == Rule::EQUIVALENCE) {
+        return equivalence();
+    }
+    else if constexpr (Entry == Rule::IMPLICATION) {
+        return implication();
+    }
+    else if constexpr (Entry == Rule::CONJUNCTION_DISJUNCTION) {
+        return conjunction_disjunction();
+    }
+    else if constexpr (Entry == Rule::CLAUSE) {
+        return clause();
+    }
+    else if constexpr (Entry == Rule::QUANTIFICATIONAL) {
+        return quantificational();
+    }
+    else if constexpr (Entry == Rule::UNARY) {
+        return unary();
+    }
+    else if constexpr (Entry == Rule::ATOMIC) {
+        return atomic();
+    }
+    else if constexpr (Entry == Rule::PREDICATION) {
+        return predication();
+    }
+    else if constexpr (Entry == Rule::IDENTITY) {
+        return identity();
+    }
+    else {
+        return inequality();
+    }
+}
+
+// Describes a failure at the token at `index`.
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+ParseError BasicParser<Mapping, Entry, Error, Builder>::errorAt(ErrorCode code, size_t index, std::string_view context, TokenType expected) const
+{
+    const TokenView found = getToken(index);
+    return { .code = code, .index = index, .expected = expected, .actual = found.type, .context = context, .found = found.literal };
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+std::unexpected<Error> BasicParser<Mapping, Entry, Error, Builder>::reject(ParseError&& error)
+{
+    return std::unexpected(ErrorTraits<Error>::make(std::move(error)));
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+std::unexpected<Error> BasicParser<Mapping, Entry, Error, Builder>::wrap(Error&& error, TokenType op)
+{
+    ErrorTraits<Error>::wrap(error, op);
+    return std::unexpected(std::move(error));
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::sentence() -> Result
+{
+    auto result = enter();
+
+    if (!result.has_value()) {
+        return std::unexpected(std::move(result).error());
+    }
+
+    if (peek() != TokenType::EOI) {
+        drop(std::move(result).value());
+        return reject(errorAt(ErrorCode::UNEXPECTED_SYMBOL, m_Index));
+    }
+
+    return result;
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::equivalence() -> Result
+{
+    return run(Rule::EQUIVALENCE);
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::implication() -> Result
+{
+    return run(Rule::IMPLICATION);
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::conjunction_disjunction() -> Result
+{
+    return run(Rule::CONJUNCTION_DISJUNCTION);
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::clause() -> Result
+{
+    return run(Rule::CLAUSE);
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::quantificational() -> Result
+{
+    return run(Rule::QUANTIFICATIONAL);
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::unary() -> Result
+{
+    return run(Rule::UNARY);
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::atomic() -> Result
+{
+    if (peek() != TokenType::IDENTIFIER && peek() != TokenType::VARIABLE) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    if (peek(1) == TokenType::LPAREN) {
+        return predication();
+    }
+
+    if (peek(1) == TokenType::ID) {
+        return identity();
+    }
+
+    if (peek(1) == TokenType::NEQ) {
+        return inequality();
+    }
+
+    return reject(errorAt(ErrorCode::EXPECTED_ATOMIC_OPERATOR, m_Index + 1, getToken(m_Index).literal));
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::predication() -> Result
+{
+    if (peek() != TokenType::IDENTIFIER) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    if (peek(1) != TokenType::LPAREN) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    if (!detail::isTerm(peek(2))) {
+        return reject(errorAt(ErrorCode::EXPECTED_TERM, m_Index + 2, getToken(m_Index + 1).literal));
+    }
+
+    if (peek(3) != TokenType::RPAREN && peek(3) != TokenType::COMMA) {
+        return reject(errorAt(ErrorCode::EXPECTED_SEPARATOR, m_Index + 3, getToken(m_Index + 2).literal));
+    }
+
+    const Checkpoint backtracking_point = mark();
+
+    const std::string_view predicate = getToken(m_Index).literal;
+
+    advance(); // consume predicate
+    advance(); // consume LPAREN
+
+    Arguments arguments = m_Builder.arguments(countArguments());
+
+    m_Builder.argument(arguments, m_Builder.term(getToken(m_Index).literal, getToken(m_Index).type));
+
+    advance(); // consume first argument
+
+    while (peek() == TokenType::COMMA) {
+        if (!detail::isTerm(peek(1))) {
+            ParseError error = errorAt(ErrorCode::EXPECTED_TERM, m_Index + 1, getToken(m_Index).literal);
+            restore(backtracking_point);
+            detail::count(&ParseStats::backtracks, 1);
+            return reject(std::move(error));
+        }
+
+        advance(); // consume comma
+
+        m_Builder.argument(arguments, m_Builder.term(getToken(m_Index).literal, getToken(m_Index).type));
+
+        advance(); // consume argument
+    }
+
+    if (peek() != TokenType::RPAREN) {
+        ParseError error = errorAt(ErrorCode::EXPECTED_ARGUMENT_LIST_END, m_Index, {}, TokenType::RPAREN);
+        restore(backtracking_point);
+        detail::count(&ParseStats::backtracks, 1);
+        return reject(std::move(error));
+    }
+
+    advance(); // consume RPAREN
+
+    Value predication = m_Builder.predication(predicate, std::move(arguments));
+    built(static_cast<size_t>(backtracking_point.index));
+    return predication;
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::identity() -> Result
+{
+    if (!detail::isTerm(peek())) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    if (peek(1) != TokenType::ID) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    if (!detail::isTerm(peek(2))) {
+        return reject(errorAt(ErrorCode::EXPECTED_RHS_TERM, m_Index + 2, getToken(m_Index + 1).literal));
+    }
+
+    TermValue lhs = m_Builder.term(getToken(m_Index).literal, getToken(m_Index).type);
+
+    advance(); // consume lhs
+    advance(); // consume ID
+
+    TermValue rhs = m_Builder.term(getToken(m_Index).literal, getToken(m_Index).type);
+
+    advance(); // consume rhs
+
+    Value id = m_Builder.identity(std::move(lhs), std::move(rhs));
+    built(static_cast<size_t>(m_Index - 3));
+    return id;
+}
+
+template<typename Mapping, Rule Entry, typename Error, typename Builder>
+auto BasicParser<Mapping, Entry, Error, Builder>::inequality() -> Result
+{
+    if (!detail::isTerm(peek())) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    if (peek(1) != TokenType::NEQ) {
+        return reject(errorAt(ErrorCode::NO_MATCH, m_Index));
+    }
+
+    // The message has always shown the '≠' token itself as what was found.
+    if (!detail::isTerm(peek(2))) {
+        return reject(errorAt(ErrorCode::EXPECTED_RHS_TERM, m_Index + 1, getToken(m_Index + 1).literal));
+    }
+
+    TermValue lhs = m_Builder.term(getToken(m_Index).literal, getToken(m_Index).type);
+
+    advance(); // consume lhs
+    advance(); // consume NEQ operator
+
+    TermValue rhs = m_Builder.term(getToken(m_Index).literal, getToken(m_Index).type);
+
+    advance(); // consume rhs
+
+    Value id = m_Builder.identity(std::move(lhs), std::move(rhs));
+    built(static_cast<size_t>(m_Index - 3));
+    if (const auto op = m_Mapping(TokenType::NOT)) {
+        Value inequality = m_Builder.unary(*op, std::move(id));
+        built(static_cast<size_t>(m_Index - 3));
+        return inequality;
+    }
+    return reject({ .code = ErrorCode::MISSING_MAP, .index = static_cast<size_t>(m_Index), .actual = TokenType::NOT });
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "maps.hpp"
+#include "parser.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @struct BatchOptions
+ * @brief Controls how `parse_batch()` distributes its work.
+ */
+struct BatchOptions {
+    /// Number of worker threads; 0 uses one per hardware thread.
+    unsigned int threads = 0;
+    /// Number of consecutive formulas a worker claims at a time.
+    size_t chunk_size = 64;
+    /// The rule every formula is parsed from.
+    Parser::ParseFunction entryPoint = &Parser::equivalence;
+    /// The mapping from tokens to operators used for every formula.
+    Parser::MappingFunction mappingFunction = &mapToAlethicOperator;
+    /// How deeply a formula may nest (see `ParserBase::setNestingLimit()`).
+    size_t nesting_limit = Parser::default_nesting_limit;
+};
+
+/**
+ * @brief Parses many formulas across a pool of threads.
+ *
+ * Each worker owns a lexer and a parser of its own; no `Parser` is ever shared between
+ * threads. The input is split into one range per worker, which claims chunks from the front
+ * of its range and, once that is exhausted, steals chunks from the ranges of the others.
+ * The entry point and the mapping function are called from every worker at once, so they
+ * must be safe to call concurrently (the built-in ones are).
+ *
+ * The formulas must stay alive until the call returns. If a worker throws, the remaining
+ * work is abandoned and the exception is rethrown on the calling thread.
+ *
+ * @param formulas The formulas to parse.
+ * @param options How to distribute the work, and how to parse each formula.
+ * @return One result per formula, in input order.
+ */
+std::vector<std::expected<QMLExpression::Expression, std::string>> parse_batch(std::span<const std::string_view> formulas, const BatchOptions& options = {});
+
+}
@@ -0,0 +1,226 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "stats.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @struct ExpressionBuilder
+ * @brief Builds the `QMLExpression::Expression` tree of a parse.
+ *
+ * This is the default builder of `BasicParser`. A builder tells the parser what to make of
+ * each construct it recognizes. It provides:
+ * - `Value`, the result of parsing a formula, and `TermValue` and `Arguments`, the results
+ *   for a term and an argument list;
+ * - `term()`, `arguments()` and `argument()`, for terms and argument lists, where
+ *   `arguments()` is told how many arguments are coming when the parser can tell;
+ * - `unary()`, `binary()`, `quantification()`, `identity()` and `predication()`, for formulas;
+ * - optionally, `span()`, told which tokens each node covers (see `SpanBuilder`).
+ *
+ * Literals are passed as views of the tokens, which are gone once parsing ends, so a builder
+ * must copy whatever it keeps.
+ */
+struct ExpressionBuilder {
+    using Value = QMLExpression::Expression;
+    using TermValue = QMLExpression::Term;
+    using Arguments = std::vector<QMLExpression::Term>;
+
+    TermValue term(std::string_view literal, TokenType type) const
+    {
+        return TermValue(std::string(literal), type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT);
+    }
+
+    Arguments arguments(size_t count) const
+    {
+        Arguments arguments;
+        arguments.reserve(count);
+        return arguments;
+    }
+
+    void argument(Arguments& arguments, TermValue term) const
+    {
+        arguments.push_back(std::move(term));
+    }
+
+    Value unary(QMLExpression::Operator op, Value scope) const
+    {
+        return makeNode<QMLExpression::UnaryNode>(op, std::move(scope));
+    }
+
+    Value binary(QMLExpression::Operator op, Value lhs, Value rhs) const
+    {
+        return makeNode<QMLExpression::BinaryNode>(op, std::move(lhs), std::move(rhs));
+    }
+
+    Value quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const
+    {
+        return makeNode<QMLExpression::QuantificationNode>(quantifier, std::move(variable), std::move(scope));
+    }
+
+    Value identity(TermValue lhs, TermValue rhs) const
+    {
+        return makeNode<QMLExpression::IdentityNode>(std::move(lhs), std::move(rhs));
+    }
+
+    Value predication(std::string_view predicate, Arguments arguments) const
+    {
+        return makeNode<QMLExpression::PredicationNode>(std::string(predicate), std::move(arguments));
+    }
+
+    /**
+     * @brief Selects where the nodes of the expression tree are allocated.
+     *
+     * Each node, together with its reference count, is placed in `resource` instead of getting
+     * a heap allocation of its own. With a `std::pmr::monotonic_buffer_resource`, the nodes of
+     * a whole batch of formulas end up next to each other and are freed at once by releasing
+     * the resource, which must outlive every expression built from it.
+     *
+     * @param resource The memory resource to allocate nodes from, or `nullptr` for the heap.
+     */
+    void setMemoryResource(std::pmr::memory_resource* resource)
+    {
+        m_Resource = resource;
+    }
+
+private:
+    // Hands every allocation to a memory resource, counting its bytes.
+    template<typename T>
+    struct CountingAllocator {
+        using value_type = T;
+
+        explicit CountingAllocator(std::pmr::memory_resource* resource)
+            : resource(resource)
+        {
+        }
+
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U>& other)
+            : resource(other.resource)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            detail::count(&ParseStats::node_bytes, n * sizeof(T));
+            return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            resource->deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        template<typename U>
+        bool operator==(const CountingAllocator<U>& other) const
+        {
+            return resource == other.resource;
+        }
+
+        std::pmr::memory_resource* resource;
+    };
+
+    template<typename Node, typename... Args>
+    std::shared_ptr<Node> makeNode(Args&&... args) const
+    {
+        if constexpr (stats_enabled) {
+            detail::count(&ParseStats::nodes, 1);
+            std::pmr::memory_resource* resource = m_Resource != nullptr ? m_Resource : std::pmr::new_delete_resource();
+            return std::allocate_shared<Node>(CountingAllocator<Node>(resource), std::forward<Args>(args)...);
+        }
+        if (m_Resource != nullptr) {
+            return std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>(m_Resource), std::forward<Args>(args)...);
+        }
+        return std::make_shared<Node>(std::forward<Args>(args)...);
+    }
+
+    std::pmr::memory_resource* m_Resource = nullptr;
+};
+
+/**
+ * @struct NullBuilder
+ * @brief Builds nothing, so that a parse only checks well-formedness.
+ */
+struct NullBuilder {
+    struct Value {};
+    struct TermValue {};
+    struct Arguments {};
+
+    constexpr TermValue term(std::string_view, TokenType) const { return {}; }
+    constexpr Arguments arguments(size_t) const { return {}; }
+    constexpr void argument(Arguments&, TermValue) const {}
+    constexpr Value unary(QMLExpression::Operator, Value) const { return {}; }
+    constexpr Value binary(QMLExpression::Operator, Value, Value) const { return {}; }
+    constexpr Value quantification(QMLExpression::Quantifier, TermValue, Value) const { return {}; }
+    constexpr Value identity(TermValue, TermValue) const { return {}; }
+    constexpr Value predication(std::string_view, Arguments) const { return {}; }
+};
+
+/**
+ * @struct SpanBuilder
+ * @brief Builds with `Inner`, recording the source span of every node in a side table.
+ *
+ * Right after building a node, the parser calls `span(begin, end)` on a builder that has
+ * it, with the indices of the first token of the node and of the token after its last one;
+ * for any other builder nothing is done and nothing is stored. This builder turns the
+ * tokens into bytes of the formula, by their spans as recorded by the spanning `lex()`,
+ * and appends them to `spans`. The nodes themselves are left as `Inner` builds them.
+ *
+ * The parser builds every node after its children, so the k-th span is that of the k-th
+ * node in postorder, the order in which a `FlatExpression` numbers them. A node spans its
+ * operands and operators, and the brackets around an operand, but not the ones around
+ * itself.
+ */
+template<typename Inner>
+struct SpanBuilder {
+    using Value = typename Inner::Value;
+    using TermValue = typename Inner::TermValue;
+    using Arguments = typename Inner::Arguments;
+
+    SpanBuilder(Inner inner, std::span<const SourceSpan> tokens, std::vector<SourceSpan>& spans)
+        : m_Inner(std::move(inner)), m_Tokens(tokens), m_Spans(&spans)
+    {
+    }
+
+    TermValue term(std::string_view literal, TokenType type) const { return m_Inner.term(literal, type); }
+    Arguments arguments(size_t count) const { return m_Inner.arguments(count); }
+    void argument(Arguments& arguments, TermValue term) const { m_Inner.argument(arguments, std::move(term)); }
+    Value unary(QMLExpression::Operator op, Value scope) const { return m_Inner.unary(op, std::move(scope)); }
+    Value binary(QMLExpression::Operator op, Value lhs, Value rhs) const { return m_Inner.binary(op, std::move(lhs), std::move(rhs)); }
+    Value quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const { return m_Inner.quantification(quantifier, std::move(variable), std::move(scope)); }
+    Value identity(TermValue lhs, TermValue rhs) const { return m_Inner.identity(std::move(lhs), std::move(rhs)); }
+    Value predication(std::string_view predicate, Arguments arguments) const { return m_Inner.predication(predicate, std::move(arguments)); }
+
+    void span(size_t begin, size_t end) const
+    {
+        m_Spans->push_back({ m_Tokens[begin].begin, m_Tokens[end - 1].end });
+    }
+
+    const Inner& inner() const
+    {
+        return m_Inner;
+    }
+
+private:
+    Inner m_Inner;
+    std::span<const SourceSpan> m_Tokens;
+    std::vector<SourceSpan>* m_Spans;
+};
+
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <expected>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <QMLExpression/expression.hpp>
+
+#include "basic_parser.hpp"
+#include "maps.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @struct CacheStats
+ * @brief Counts what a `ParseCache` did since it was created.
+ */
+struct CacheStats {
+    /// Lookups answered from the cache.
+    size_t hits = 0;
+    /// Lookups that had to parse.
+    size_t misses = 0;
+    /// Results dropped to make room for newer ones.
+    size_t evictions = 0;
+};
+
+/**
+ * @class ParseCache
+ * @brief Remembers the results of recent parses, keyed by formula, entry rule and modality.
+ *
+ * Holds at most `capacity` results, and drops the least recently used one to make room for
+ * a new one. Failures are remembered as well as successes. On a hit, the expression
+ * returned shares its nodes with the cached one and with every other hit, so it must be
+ * treated as immutable.
+ *
+ * The cache can be used from many threads at once. It is split into shards, each with its
+ * own lock and its own share of the capacity, by the hash of the key; a miss parses without
+ * holding any lock.
+ */
+class ParseCache
+{
+public:
+    using Result = std::expected<QMLExpression::Expression, std::string>;
+
+    explicit ParseCache(size_t capacity, size_t shards = 16);
+    ~ParseCache();
+    ParseCache(const ParseCache&) = delete;
+    ParseCache& operator=(const ParseCache&) = delete;
+
+    Result parse(std::string_view formula, Rule entry = Rule::EQUIVALENCE, Modality modality = Modality::ALETHIC);
+
+    CacheStats stats() const;
+    size_t size() const;
+    void clear();
+
+private:
+    struct KeyView {
+        std::string_view formula;
+        Rule entry;
+        Modality modality;
+    };
+
+    struct Entry {
+        std::string formula;
+        Rule entry;
+        Modality modality;
+        Result result;
+    };
+
+    struct Hash {
+        size_t operator()(const KeyView& key) const;
+    };
+
+    struct Equal {
+        bool operator()(const KeyView& lhs, const KeyView& rhs) const;
+    };
+
+    // Most recently used first; the index refers to the formulas stored in the entries.
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        size_t capacity = 0;
+        std::list<Entry> entries;
+        std::unordered_map<KeyView, std::list<Entry>::iterator, Hash, Equal> index;
+    };
+
+    Shard& shardFor(size_t hash);
+
+    std::unique_ptr<Shard[]> m_Shards;
+    size_t m_ShardCount;
+
+    std::atomic<size_t> m_Hits;
+    std::atomic<size_t> m_Misses;
+    std::atomic<size_t> m_Evictions;
+};
+
+}
@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @enum ErrorCode
+ * @brief Identifies what went wrong in a failed parse.
+ */
+enum class ErrorCode {
+    NO_MATCH,                   ///< The rule does not apply at this token (the message is empty).
+    EMPTY_INPUT,                ///< There were no tokens at all.
+    UNEXPECTED_SYMBOL,          ///< A complete formula was followed by more tokens.
+    UNEXPECTED_TOKEN,           ///< No clause can start with the token found.
+    MISSING_MAP,                ///< The mapping has no operator for the connective in `actual`.
+    MISSING_UNARY_MAP,          ///< The mapping has no operator for the unary operator in `actual`.
+    EXPECTED_CLOSING,           ///< A parenthesis or bracket was not closed; `expected` says which.
+    EXPECTED_VARIABLE,          ///< A quantifier was not followed by a variable.
+    EXPECTED_CLAUSE,            ///< The unary operator in `actual` was not followed by a clause.
+    EXPECTED_ATOMIC_OPERATOR,   ///< A term was not followed by '(', '=' or '≠'.
+    EXPECTED_TERM,              ///< An argument list is missing a term.
+    EXPECTED_SEPARATOR,         ///< A term in an argument list was not followed by ',' or ')'.
+    EXPECTED_ARGUMENT_LIST_END, ///< An argument list was not closed.
+    EXPECTED_RHS_TERM,          ///< An identity or inequality is missing its right-hand side.
+    NESTING_TOO_DEEP            ///< The prefix or bracket at `index` went past the nesting limit.
+};
+
+/**
+ * @struct ParseError
+ * @brief Describes a failed parse without formatting any text.
+ *
+ * Nothing is allocated when an error is raised: `context` and `found` refer to the literals
+ * of the tokens involved, so the error must not outlive those tokens (the input buffer for
+ * `lex_view()` tokens and `Lexer`, or the parser itself when it owns its tokens). The text
+ * is only built by `message()`, and it is the same text the `Parser` reports.
+ */
+struct ParseError {
+    std::string message() const;
+
+    /// What went wrong.
+    ErrorCode code = ErrorCode::NO_MATCH;
+    /// The index of the offending token.
+    size_t index = 0;
+    /// The type of token that was required, where a single one was.
+    TokenType expected = TokenType::NIL;
+    /// The type of the offending token; for the map and unary operator codes, the operator.
+    TokenType actual = TokenType::NIL;
+    /// The literal of the token the offending one came after, if the message mentions it.
+    std::string_view context = {};
+    /// The literal of the offending token.
+    std::string_view found = {};
+    /// The binary connectives whose right-hand side failed to parse, innermost first.
+    std::vector<TokenType> operators = {};
+};
+
+/**
+ * @struct Rejection
+ * @brief An error that records nothing, for when only success or failure matters.
+ */
+struct Rejection {};
+
+/**
+ * @struct ErrorTraits
+ * @brief Tells `BasicParser` how to build and extend errors of type `Error`.
+ *
+ * `make()` turns a `ParseError` into an `Error`, and `wrap()` records that the right-hand
+ * side of the binary connective `op` failed with `error`.
+ */
+template<typename Error>
+struct ErrorTraits;
+
+template<>
+struct ErrorTraits<std::string> {
+    static std::string make(ParseError&& error);
+    static void wrap(std::string& error, TokenType op);
+};
+
+template<>
+struct ErrorTraits<ParseError> {
+    static ParseError make(ParseError&& error)
+    {
+        return std::move(error);
+    }
+
+    static void wrap(ParseError& error, TokenType op)
+    {
+        error.operators.push_back(op);
+    }
+};
+
+template<>
+struct ErrorTraits<Rejection> {
+    static Rejection make(ParseError&&)
+    {
+        return {};
+    }
+
+    static void wrap(Rejection&, TokenType)
+    {
+    }
+};
+
+}
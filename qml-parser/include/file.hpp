@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <QMLExpression/expression.hpp>
+
+#include "maps.hpp"
+#include "parser.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class MappedFile
+ * @brief Maps a file into memory, read-only, for as long as it lives.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const std::byte> bytes() const;
+    std::string_view text() const;
+
+private:
+    void unmap();
+
+    const std::byte* m_Data = nullptr;
+    size_t m_Size = 0;
+};
+
+/**
+ * @struct FileOptions
+ * @brief Controls how `parse_file()` distributes its work.
+ */
+struct FileOptions {
+    /// Number of worker threads; 0 uses one per hardware thread.
+    unsigned int threads = 0;
+    /// Number of bytes of the file a worker claims at a time.
+    size_t chunk_bytes = size_t{ 1 } << 20;
+    /// The rule every formula is parsed from.
+    Parser::ParseFunction entryPoint = &Parser::equivalence;
+    /// The mapping from tokens to operators used for every formula.
+    Parser::MappingFunction mappingFunction = &mapToAlethicOperator;
+    /// How deeply a formula may nest (see `ParserBase::setNestingLimit()`).
+    size_t nesting_limit = Parser::default_nesting_limit;
+};
+
+/**
+ * @struct FileRecord
+ * @brief A formula read from a file by `parse_file()`, and the result of parsing it.
+ */
+struct FileRecord {
+    /// The number of the line holding the formula, counting from 1.
+    size_t line;
+    /// Where the line starts in the file, in bytes.
+    size_t offset;
+    /// The formula, without its line ending; a view into the mapped file.
+    std::string_view formula;
+    /// What `parse()` gives for the formula.
+    std::expected<QMLExpression::Expression, std::string> result;
+};
+
+/**
+ * @brief Parses a file of formulas, one per line, across a pool of threads.
+ *
+ * The file is mapped into memory and split into chunks of whole lines, which workers claim
+ * one after another, so each part of the file is read once and no line is copied. Each
+ * worker owns its parser, as in `parse_batch()`. Lines may end in `\n` or `\r\n`; lines
+ * left empty are skipped, but counted.
+ *
+ * Every record is handed to `callback` on the worker that parsed it, as soon as it is
+ * parsed, and dropped afterwards, so memory use does not grow with the size of the file.
+ * Records come in file order within a chunk, but chunks are handled at the same time, so
+ * the callback must be safe to call from several threads at once; it may move the result
+ * out of the record. The views in the record are only valid during the call.
+ *
+ * If the callback or a worker throws, the remaining work is abandoned and the exception is
+ * rethrown on the calling thread.
+ *
+ * @param path The file to parse.
+ * @param callback The function to hand each record to.
+ * @param options How to distribute the work, and how to parse each formula.
+ * @return The number of formulas parsed.
+ * @throws std::system_error if the file cannot be mapped.
+ */
+size_t parse_file(const std::filesystem::path& path, const std::function<void(FileRecord&)>& callback, const FileOptions& options = {});
+
+}
@@ -0,0 +1,128 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "symbols.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class FlatExpression
+ * @brief Holds parsed formulas as flat arrays of nodes, instead of trees of pointers.
+ *
+ * The nodes of all the formulas parsed into it are numbered in postorder, one formula after
+ * the other, so every node comes after its children and each formula ends at its root. Each
+ * property of the nodes is a separate array, indexed by node:
+ * - `kinds()`, the kind of node;
+ * - `tags()`, the `QMLExpression::Operator` of a unary or binary node, or the
+ *   `QMLExpression::Quantifier` of a quantification, as its underlying value;
+ * - `first()` and `second()`, its operands, which depend on the kind:
+ *   - `UNARY`: the scope, as a node;
+ *   - `BINARY`: the left-hand and right-hand sides, as nodes;
+ *   - `QUANTIFICATION`: the variable, as a term, and the scope, as a node;
+ *   - `IDENTITY`: the left-hand and right-hand sides, as terms;
+ *   - `PREDICATION`: the predicate, as a name, and where its argument list starts in
+ *     `arguments()`, where the number of arguments is followed by their terms.
+ *
+ * Each distinct term is numbered once, with its name in `termNames()` and its type in
+ * `termTypes()`. Names are interned in a `SymbolTable`, which several flat expressions can
+ * share, so that equal names are equal numbers across all of them.
+ */
+class FlatExpression
+{
+public:
+    using Index = uint32_t;
+
+    enum class Kind : uint8_t { UNARY, BINARY, QUANTIFICATION, IDENTITY, PREDICATION };
+
+    FlatExpression();
+    explicit FlatExpression(std::shared_ptr<SymbolTable> names);
+
+    size_t size() const;
+    Index root(size_t formula) const;
+    QMLExpression::Expression expression(size_t formula) const;
+    void clear();
+
+    std::span<const Kind> kinds() const;
+    std::span<const uint8_t> tags() const;
+    std::span<const Index> first() const;
+    std::span<const Index> second() const;
+    std::span<const Index> arguments() const;
+
+    std::span<const SymbolTable::Symbol> termNames() const;
+    std::span<const QMLExpression::Term::Type> termTypes() const;
+    const SymbolTable& names() const;
+
+private:
+    friend struct FlatBuilder;
+
+    Index node(Kind kind, uint8_t tag, Index first, Index second);
+
+    std::shared_ptr<SymbolTable> m_Names;
+
+    std::vector<Kind> m_Kinds;
+    std::vector<uint8_t> m_Tags;
+    std::vector<Index> m_First;
+    std::vector<Index> m_Second;
+    std::vector<Index> m_Arguments;
+    std::vector<Index> m_Roots;
+
+    std::vector<SymbolTable::Symbol> m_TermNames;
+    std::vector<QMLExpression::Term::Type> m_TermTypes;
+    // Each term, by its name and type, so that it is numbered once.
+    std::unordered_map<uint64_t, Index> m_Terms;
+};
+
+/**
+ * @struct FlatBuilder
+ * @brief Builds the nodes of a parse straight into a `FlatExpression`.
+ *
+ * Values are node numbers, terms are term numbers, and an argument list is where it starts
+ * in the arguments of the flat expression. Nothing is allocated for a node beyond its place
+ * in the arrays.
+ */
+struct FlatBuilder {
+    using Value = FlatExpression::Index;
+    using TermValue = FlatExpression::Index;
+
+    struct Arguments {
+        FlatExpression::Index begin;
+    };
+
+    explicit FlatBuilder(FlatExpression& into);
+
+    TermValue term(std::string_view literal, TokenType type) const;
+    Arguments arguments(size_t count) const;
+    void argument(Arguments& arguments, TermValue term) const;
+    Value unary(QMLExpression::Operator op, Value scope) const;
+    Value binary(QMLExpression::Operator op, Value lhs, Value rhs) const;
+    Value quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const;
+    Value identity(TermValue lhs, TermValue rhs) const;
+    Value predication(std::string_view predicate, Arguments arguments) const;
+
+    void commit(Value root) const;
+    void discard() const;
+
+private:
+    FlatExpression* m_Flat;
+    // The sizes of the arrays before the formula being parsed.
+    size_t m_Nodes;
+    size_t m_Arguments;
+};
+
+}
@@ -0,0 +1,623 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "basic_parser.hpp"
+#include "builder.hpp"
+#include "dfa.hpp"
+#include "error.hpp"
+#include "flat.hpp"
+#include "maps.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace detail {
+    struct StaticWriter;
+}
+
+/**
+ * @class StaticExpression
+ * @brief A formula parsed at compile time, held in fixed-size arrays.
+ *
+ * Made by `static_expression` and the `_qml` literal. The nodes are laid out as in a
+ * `FlatExpression` holding a single formula, in postorder, so the root is the last node;
+ * the operands in `first()` and `second()` are nodes or terms in the same way, except that
+ * the predicate of a `PREDICATION` is a term too. Terms are not shared: each occurrence is
+ * a slice of `formula()`, with its type.
+ *
+ * Nothing is allocated until `expression()` builds the `QMLExpression::Expression` tree.
+ */
+template<size_t Length, size_t Nodes, size_t Terms, size_t Slots>
+class StaticExpression
+{
+public:
+    using Index = FlatExpression::Index;
+    using Kind = FlatExpression::Kind;
+
+    /**
+     * @struct Term
+     * @brief A term, or a predicate, as the slice of the formula that names it.
+     */
+    struct Term {
+        Index offset = 0;
+        Index length = 0;
+        QMLExpression::Term::Type type = QMLExpression::Term::Type::CONSTANT;
+    };
+
+    constexpr std::string_view formula() const { return { m_Formula.data(), Length }; }
+    constexpr size_t size() const { return Nodes; }
+    constexpr Index root() const { return static_cast<Index>(Nodes - 1); }
+
+    constexpr std::span<const Kind, Nodes> kinds() const { return m_Kinds; }
+    constexpr std::span<const uint8_t, Nodes> tags() const { return m_Tags; }
+    constexpr std::span<const Index, Nodes> first() const { return m_First; }
+    constexpr std::span<const Index, Nodes> second() const { return m_Second; }
+    constexpr std::span<const Index, Slots> arguments() const { return m_Arguments; }
+    constexpr std::span<const Term, Terms> terms() const { return m_Terms; }
+
+    /**
+     * @brief Gives the name of a term, or of a predicate.
+     * @param term The number of the term.
+     */
+    constexpr std::string_view name(Index term) const
+    {
+        return formula().substr(m_Terms[term].offset, m_Terms[term].length);
+    }
+
+    QMLExpression::Expression expression() const;
+
+    operator QMLExpression::Expression() const
+    {
+        return expression();
+    }
+
+private:
+    friend struct detail::StaticWriter;
+
+    std::array<char, Length> m_Formula{};
+    std::array<Kind, Nodes> m_Kinds{};
+    std::array<uint8_t, Nodes> m_Tags{};
+    std::array<Index, Nodes> m_First{};
+    std::array<Index, Nodes> m_Second{};
+    std::array<Index, Slots> m_Arguments{};
+    std::array<Term, Terms> m_Terms{};
+};
+
+/**
+ * @brief Builds the `QMLExpression::Expression` tree of the formula.
+ * @return The same tree `parse()` gives for the formula.
+ */
+template<size_t Length, size_t Nodes, size_t Terms, size_t Slots>
+QMLExpression::Expression StaticExpression<Length, Nodes, Terms, Slots>::expression() const
+{
+    const ExpressionBuilder builder;
+    const auto term = [&](Index index) {
+        return QMLExpression::Term(std::string(name(index)), m_Terms[index].type);
+    };
+
+    std::vector<QMLExpression::Expression> built;
+    built.reserve(Nodes);
+
+    for (Index i = 0; i < Nodes; ++i) {
+        switch (m_Kinds[i]) {
+        case Kind::UNARY:
+            built.push_back(builder.unary(static_cast<QMLExpression::Operator>(m_Tags[i]), built[m_First[i]]));
+            break;
+        case Kind::BINARY:
+            built.push_back(builder.binary(static_cast<QMLExpression::Operator>(m_Tags[i]), built[m_First[i]], built[m_Second[i]]));
+            break;
+        case Kind::QUANTIFICATION:
+            built.push_back(builder.quantification(static_cast<QMLExpression::Quantifier>(m_Tags[i]), term(m_First[i]), built[m_Second[i]]));
+            break;
+        case Kind::IDENTITY:
+            built.push_back(builder.identity(term(m_First[i]), term(m_Second[i])));
+            break;
+        case Kind::PREDICATION: {
+            const Index count = m_Arguments[m_Second[i]];
+            ExpressionBuilder::Arguments arguments;
+            arguments.reserve(count);
+            for (Index k = 1; k <= count; ++k) {
+                arguments.push_back(term(m_Arguments[m_Second[i] + k]));
+            }
+            built.push_back(builder.predication(name(m_First[i]), std::move(arguments)));
+            break;
+        }
+        }
+    }
+
+    return std::move(built.back());
+}
+
+namespace detail {
+    /*
+     * A formula given as a template argument. The terminating NUL is kept, since it is part
+     * of the literal, but not counted in `view()`.
+     */
+    template<size_t N>
+    struct FormulaString {
+        consteval FormulaString(const char (&formula)[N])
+        {
+            std::copy_n(formula, N, data);
+        }
+
+        constexpr std::string_view view() const
+        {
+            return { data, N - 1 };
+        }
+
+        char data[N]{};
+    };
+
+    /*
+     * None of these is constexpr, so reaching one while a formula is compiled stops the
+     * compilation, and the compiler names the function, which says what went wrong.
+     */
+    inline void qml_formula_has_an_illegal_symbol() {}
+    inline void qml_formula_has_symbols_after_its_end() {}
+    inline void qml_formula_has_a_clause_starting_with_an_unexpected_token() {}
+    inline void qml_formula_has_an_unclosed_bracket() {}
+    inline void qml_formula_has_a_quantifier_without_a_variable() {}
+    inline void qml_formula_has_a_term_without_an_atomic_operator() {}
+    inline void qml_formula_has_an_argument_list_missing_a_term() {}
+    inline void qml_formula_has_an_argument_without_a_separator() {}
+    inline void qml_formula_has_an_unclosed_argument_list() {}
+    inline void qml_formula_has_an_identity_missing_its_right_hand_side() {}
+    inline void qml_formula_does_not_start_with_the_entry_rule() {}
+
+    constexpr void fail(ErrorCode code)
+    {
+        switch (code) {
+        case ErrorCode::UNEXPECTED_SYMBOL: qml_formula_has_symbols_after_its_end(); break;
+        case ErrorCode::EMPTY_INPUT:
+        case ErrorCode::UNEXPECTED_TOKEN: qml_formula_has_a_clause_starting_with_an_unexpected_token(); break;
+        case ErrorCode::EXPECTED_CLOSING: qml_formula_has_an_unclosed_bracket(); break;
+        case ErrorCode::EXPECTED_VARIABLE: qml_formula_has_a_quantifier_without_a_variable(); break;
+        case ErrorCode::EXPECTED_ATOMIC_OPERATOR: qml_formula_has_a_term_without_an_atomic_operator(); break;
+        case ErrorCode::EXPECTED_TERM: qml_formula_has_an_argument_list_missing_a_term(); break;
+        case ErrorCode::EXPECTED_SEPARATOR: qml_formula_has_an_argument_without_a_separator(); break;
+        case ErrorCode::EXPECTED_ARGUMENT_LIST_END: qml_formula_has_an_unclosed_argument_list(); break;
+        case ErrorCode::EXPECTED_RHS_TERM: qml_formula_has_an_identity_missing_its_right_hand_side(); break;
+        default: qml_formula_does_not_start_with_the_entry_rule(); break;
+        }
+    }
+
+    struct StaticToken {
+        TokenType type = TokenType::NIL;
+        uint32_t begin = 0;
+        uint32_t length = 0;
+    };
+
+    // Collects the tokens of `run<true>()`; with no room for them, only counts them.
+    template<size_t Capacity>
+    struct StaticTokenSink {
+        std::string_view formula;
+        std::array<StaticToken, Capacity> tokens{};
+        size_t count = 0;
+        size_t identifier_begin = 0;
+        size_t identifier_length = 0;
+
+        constexpr void append(std::string_view, size_t pos, size_t length)
+        {
+            if (identifier_length == 0) {
+                identifier_begin = pos;
+            }
+            identifier_length += length;
+        }
+
+        constexpr void flushIdentifier()
+        {
+            if (identifier_length == 0) {
+                return;
+            }
+            const std::string_view identifier = formula.substr(identifier_begin, identifier_length);
+            emit(identifier, isVariable(identifier) ? TokenType::VARIABLE : TokenType::IDENTIFIER);
+            identifier_length = 0;
+        }
+
+        constexpr void emit(std::string_view literal, TokenType type)
+        {
+            if (type == TokenType::ILLEGAL) {
+                qml_formula_has_an_illegal_symbol();
+            }
+            if constexpr (Capacity != 0) {
+                tokens[count] = { type, static_cast<uint32_t>(literal.data() - formula.data()), static_cast<uint32_t>(literal.size()) };
+            }
+            ++count;
+        }
+    };
+
+    // Lexes into `Capacity` tokens, the last of which is EOI.
+    template<size_t Capacity>
+    constexpr StaticTokenSink<Capacity> lexStatic(std::string_view formula)
+    {
+        StaticTokenSink<Capacity> sink{ .formula = formula };
+        run<true, ScalarScanner>(formula, sink);
+        if constexpr (Capacity != 0) {
+            sink.tokens[sink.count] = { TokenType::EOI, static_cast<uint32_t>(formula.size()), 0 };
+        }
+        ++sink.count;
+        return sink;
+    }
+
+    // Counts what a formula needs, on the first of the two passes over it.
+    struct StaticSizes {
+        using Index = FlatExpression::Index;
+
+        size_t nodes = 0;
+        size_t terms = 0;
+        size_t slots = 0;
+
+        constexpr Index node(FlatExpression::Kind, uint8_t, Index, Index) { return static_cast<Index>(nodes++); }
+        constexpr Index term(const StaticToken&, QMLExpression::Term::Type) { return static_cast<Index>(terms++); }
+        constexpr Index list() { return static_cast<Index>(slots++); }
+        constexpr void argument(Index, Index) { ++slots; }
+    };
+
+    // Fills a `StaticExpression`, on the second pass.
+    struct StaticWriter {
+        using Index = FlatExpression::Index;
+
+        template<typename Expression>
+        struct Into {
+            Expression& expression;
+            StaticSizes used{};
+
+            constexpr Index node(FlatExpression::Kind kind, uint8_t tag, Index first, Index second)
+            {
+                expression.m_Kinds[used.nodes] = kind;
+                expression.m_Tags[used.nodes] = tag;
+                expression.m_First[used.nodes] = first;
+                expression.m_Second[used.nodes] = second;
+                return used.node(kind, tag, first, second);
+            }
+
+            constexpr Index term(const StaticToken& token, QMLExpression::Term::Type type)
+            {
+                expression.m_Terms[used.terms] = { token.begin, token.length, type };
+                return used.term(token, type);
+            }
+
+            constexpr Index list()
+            {
+                expression.m_Arguments[used.slots] = 0;
+                return used.list();
+            }
+
+            constexpr void argument(Index list, Index term)
+            {
+                ++expression.m_Arguments[list];
+                expression.m_Arguments[used.slots] = term;
+                used.argument(list, term);
+            }
+        };
+
+        template<typename Expression>
+        static constexpr Into<Expression> into(Expression& expression, std::string_view formula)
+        {
+            std::copy(formula.begin(), formula.end(), expression.m_Formula.begin());
+            return { expression };
+        }
+    };
+
+    /*
+     * The rules of `BasicParser`, as plain recursive descent over tokens lexed at compile
+     * time. Every failure of `BasicParser` ends the parse, so each rule stops at the
+     * first one, where `fail()` stops the compilation.
+     */
+    template<Rule Entry, Modality M, typename Out>
+    class StaticParser
+    {
+    public:
+        using Index = FlatExpression::Index;
+        using Kind = FlatExpression::Kind;
+
+        constexpr StaticParser(std::span<const StaticToken> tokens, Out& out)
+            : m_Tokens(tokens), m_Out(out)
+        {
+        }
+
+        constexpr Index sentence()
+        {
+            const Index root = enter();
+            if (peek() != TokenType::EOI) {
+                fail(ErrorCode::UNEXPECTED_SYMBOL);
+            }
+            return root;
+        }
+
+    private:
+        constexpr Index enter()
+        {
+            switch (Entry) {
+            case Rule::EQUIVALENCE: return equivalence();
+            case Rule::IMPLICATION: return implication();
+            case Rule::CONJUNCTION_DISJUNCTION: return conjunction_disjunction();
+            case Rule::CLAUSE: return clause();
+            case Rule::QUANTIFICATIONAL: return quantificational();
+            case Rule::UNARY: return unary();
+            case Rule::ATOMIC: return atomic();
+            case Rule::PREDICATION: return predication();
+            case Rule::IDENTITY: return identity();
+            default: return inequality();
+            }
+        }
+
+        constexpr TokenType peek(size_t offset = 0) const
+        {
+            return m_Index + offset < m_Tokens.size() ? m_Tokens[m_Index + offset].type : TokenType::EOI;
+        }
+
+        constexpr void advance()
+        {
+            if (peek() != TokenType::EOI) {
+                ++m_Index;
+            }
+        }
+
+        static constexpr uint8_t tag(TokenType type)
+        {
+            return static_cast<uint8_t>(*ModalMapping<M>{}(type));
+        }
+
+        // Consumes a term.
+        constexpr Index term()
+        {
+            const StaticToken& token = m_Tokens[m_Index];
+            advance();
+            return m_Out.term(token, token.type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT);
+        }
+
+        constexpr Index equivalence()
+        {
+            Index lhs = implication();
+            while (peek() == TokenType::EQ) {
+                advance();
+                const Index rhs = implication();
+                lhs = m_Out.node(Kind::BINARY, tag(TokenType::EQ), lhs, rhs);
+            }
+            return lhs;
+        }
+
+        constexpr Index implication()
+        {
+            Index lhs = conjunction_disjunction();
+            while (peek() == TokenType::IF) {
+                advance();
+                const Index rhs = conjunction_disjunction();
+                lhs = m_Out.node(Kind::BINARY, tag(TokenType::IF), lhs, rhs);
+            }
+            return lhs;
+        }
+
+        constexpr Index conjunction_disjunction()
+        {
+            Index lhs = clause();
+            while (peek() == TokenType::AND || peek() == TokenType::OR) {
+                const TokenType connective = peek();
+                advance();
+                const Index rhs = clause();
+                lhs = m_Out.node(Kind::BINARY, tag(connective), lhs, rhs);
+            }
+            return lhs;
+        }
+
+        constexpr Index clause()
+        {
+            const TokenType current = peek();
+
+            if (isTerm(current)) {
+                return atomic();
+            }
+            if (isUnaryOperator(current)) {
+                return unary();
+            }
+            if (isQuantifier(current)) {
+                return quantificational();
+            }
+            if (current == TokenType::LPAREN || current == TokenType::LBRACKET) {
+                advance();
+                const Index inner = enter();
+                if (peek() != (current == TokenType::LPAREN ? TokenType::RPAREN : TokenType::RBRACKET)) {
+                    fail(ErrorCode::EXPECTED_CLOSING);
+                }
+                advance();
+                return inner;
+            }
+
+            fail(m_Tokens.size() == 1 ? ErrorCode::EMPTY_INPUT : ErrorCode::UNEXPECTED_TOKEN);
+            return 0;
+        }
+
+        constexpr Index quantificational()
+        {
+            if (!isQuantifier(peek())) {
+                fail(ErrorCode::NO_MATCH);
+            }
+            if (peek(1) != TokenType::VARIABLE) {
+                fail(ErrorCode::EXPECTED_VARIABLE);
+            }
+
+            const TokenType quantifier = peek();
+            advance();
+            const Index variable = term();
+            const Index scope = clause();
+
+            const QMLExpression::Quantifier q = quantifier == TokenType::FORALL ? QMLExpression::Quantifier::UNIVERSAL : QMLExpression::Quantifier::EXISTENTIAL;
+            const Index quantified = m_Out.node(Kind::QUANTIFICATION, static_cast<uint8_t>(q), variable, scope);
+            if (quantifier != TokenType::NOT_EXISTS) {
+                return quantified;
+            }
+            return m_Out.node(Kind::UNARY, tag(TokenType::NOT), quantified, 0);
+        }
+
+        constexpr Index unary()
+        {
+            if (!isUnaryOperator(peek())) {
+                fail(ErrorCode::NO_MATCH);
+            }
+
+            const TokenType op = peek();
+            advance();
+            const Index scope = clause();
+            return m_Out.node(Kind::UNARY, tag(op), scope, 0);
+        }
+
+        constexpr Index atomic()
+        {
+            if (!isTerm(peek())) {
+                fail(ErrorCode::NO_MATCH);
+            }
+
+            switch (peek(1)) {
+            case TokenType::LPAREN: return predication();
+            case TokenType::ID: return identity();
+            case TokenType::NEQ: return inequality();
+            default:
+                fail(ErrorCode::EXPECTED_ATOMIC_OPERATOR);
+                return 0;
+            }
+        }
+
+        constexpr Index predication()
+        {
+            if (peek() != TokenType::IDENTIFIER || peek(1) != TokenType::LPAREN) {
+                fail(ErrorCode::NO_MATCH);
+            }
+            if (!isTerm(peek(2))) {
+                fail(ErrorCode::EXPECTED_TERM);
+            }
+            if (peek(3) != TokenType::RPAREN && peek(3) != TokenType::COMMA) {
+                fail(ErrorCode::EXPECTED_SEPARATOR);
+            }
+
+            const Index predicate = term();
+            advance(); // consume LPAREN
+
+            const Index list = m_Out.list();
+            m_Out.argument(list, term());
+
+            while (peek() == TokenType::COMMA) {
+                if (!isTerm(peek(1))) {
+                    fail(ErrorCode::EXPECTED_TERM);
+                }
+                advance(); // consume comma
+                m_Out.argument(list, term());
+            }
+
+            if (peek() != TokenType::RPAREN) {
+                fail(ErrorCode::EXPECTED_ARGUMENT_LIST_END);
+            }
+            advance(); // consume RPAREN
+
+            return m_Out.node(Kind::PREDICATION, 0, predicate, list);
+        }
+
+        constexpr Index identity()
+        {
+            if (!isTerm(peek()) || peek(1) != TokenType::ID) {
+                fail(ErrorCode::NO_MATCH);
+            }
+            if (!isTerm(peek(2))) {
+                fail(ErrorCode::EXPECTED_RHS_TERM);
+            }
+
+            const Index lhs = term();
+            advance(); // consume ID
+            const Index rhs = term();
+            return m_Out.node(Kind::IDENTITY, 0, lhs, rhs);
+        }
+
+        constexpr Index inequality()
+        {
+            if (!isTerm(peek()) || peek(1) != TokenType::NEQ) {
+                fail(ErrorCode::NO_MATCH);
+            }
+            if (!isTerm(peek(2))) {
+                fail(ErrorCode::EXPECTED_RHS_TERM);
+            }
+
+            const Index lhs = term();
+            advance(); // consume NEQ
+            const Index rhs = term();
+            const Index id = m_Out.node(Kind::IDENTITY, 0, lhs, rhs);
+            return m_Out.node(Kind::UNARY, tag(TokenType::NOT), id, 0);
+        }
+
+        std::span<const StaticToken> m_Tokens;
+        size_t m_Index = 0;
+        Out& m_Out;
+    };
+
+    template<FormulaString Formula>
+    inline constexpr size_t static_token_count = lexStatic<0>(Formula.view()).count;
+
+    template<FormulaString Formula>
+    inline constexpr auto static_tokens = lexStatic<static_token_count<Formula>>(Formula.view()).tokens;
+
+    template<FormulaString Formula, Rule Entry, Modality M>
+    consteval StaticSizes measure()
+    {
+        StaticSizes sizes;
+        StaticParser<Entry, M, StaticSizes>(static_tokens<Formula>, sizes).sentence();
+        return sizes;
+    }
+
+    template<FormulaString Formula, Rule Entry, Modality M>
+    consteval auto compile()
+    {
+        static_assert(Entry != Rule::DYNAMIC, "A formula compiled at compile time needs a fixed entry rule");
+
+        constexpr StaticSizes sizes = measure<Formula, Entry, M>();
+        StaticExpression<Formula.view().size(), sizes.nodes, sizes.terms, sizes.slots> expression;
+        auto into = StaticWriter::into(expression, Formula.view());
+        StaticParser<Entry, M, decltype(into)>(static_tokens<Formula>, into).sentence();
+        return expression;
+    }
+}
+
+/**
+ * @brief A formula parsed at compile time.
+ *
+ * Lexes and parses `Formula` as `parse()` would from `Entry`, reading the modal operators
+ * under `M`, while the program is compiled: a malformed formula does not compile, and the
+ * error names the function that records what is wrong with it. Bytes that `parse()`
+ * silently drops, such as stray UTF-8 continuation bytes, are rejected too.
+ *
+ * @tparam Formula The formula, as a string literal.
+ * @tparam Entry The rule the formula is parsed from.
+ * @tparam M The reading of the modal operators.
+ */
+template<detail::FormulaString Formula, Rule Entry = Rule::EQUIVALENCE, Modality M = Modality::ALETHIC>
+inline constexpr auto static_expression = detail::compile<Formula, Entry, M>();
+
+namespace literals {
+    /**
+     * @brief Parses a formula at compile time, from `Rule::EQUIVALENCE` under the alethic reading.
+     *
+     * `"∀x □P(x)"_qml` is `static_expression<"∀x □P(x)">`, which converts to a
+     * `QMLExpression::Expression` on demand.
+     */
+    template<detail::FormulaString Formula>
+    consteval const auto& operator""_qml()
+    {
+        return static_expression<Formula>;
+    }
+}
+
+}
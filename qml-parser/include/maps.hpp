@@ -8,6 +8,50 @@
 
 namespace iif_sadaf::talk::QMLParser {
 
+/**
+ * @enum Modality
+ * @brief The readings of the modal operators □ and ⋄ supported out of the box.
+ */
+enum class Modality {
+    ALETHIC,
+    DEONTIC,
+    EPISTEMIC
+};
+
+/**
+ * @struct ModalMapping
+ * @brief Maps token types to operators under a fixed modality.
+ *
+ * The same maps as `mapToAlethicOperator()` and its siblings, as a stateless functor that
+ * `BasicParser` can call, and inline, without going through a function pointer.
+ */
+template<Modality M>
+struct ModalMapping {
+    constexpr std::optional<QMLExpression::Operator> operator()(TokenType type) const
+    {
+        switch (type) {
+        case TokenType::NOT: return QMLExpression::Operator::NEGATION;
+        case TokenType::AND: return QMLExpression::Operator::CONJUNCTION;
+        case TokenType::OR: return QMLExpression::Operator::DISJUNCTION;
+        case TokenType::IF: return QMLExpression::Operator::CONDITIONAL;
+        case TokenType::EQ: return QMLExpression::Operator::BICONDITIONAL;
+        case TokenType::NEC:
+            return M == Modality::ALETHIC ? QMLExpression::Operator::NECESSITY
+                 : M == Modality::DEONTIC ? QMLExpression::Operator::DEONTIC_NECESSITY
+                                          : QMLExpression::Operator::EPISTEMIC_NECESSITY;
+        case TokenType::POS:
+            return M == Modality::ALETHIC ? QMLExpression::Operator::POSSIBILITY
+                 : M == Modality::DEONTIC ? QMLExpression::Operator::DEONTIC_POSSIBILITY
+                                          : QMLExpression::Operator::EPISTEMIC_POSSIBILITY;
+        default: return std::nullopt;
+        }
+    }
+};
+
+using AlethicMapping = ModalMapping<Modality::ALETHIC>;
+using DeonticMapping = ModalMapping<Modality::DEONTIC>;
+using EpistemicMapping = ModalMapping<Modality::EPISTEMIC>;
+
 std::optional<QMLExpression::Operator> mapToAlethicOperator(TokenType type);
 std::optional<QMLExpression::Operator> mapToDeonticOperator(TokenType type);
 std::optional<QMLExpression::Operator> mapToEpistemicOperator(TokenType type);
@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <string>
+#include <string_view>
+
+#include <QMLExpression/expression.hpp>
+
+#include "maps.hpp"
+#include "parser.hpp"
+#include "teardown.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @struct ParallelOptions
+ * @brief Controls how `parse_parallel()` splits a formula.
+ */
+struct ParallelOptions {
+    /// Number of worker threads; 0 uses one per hardware thread.
+    unsigned int threads = 0;
+    /// Number of tokens below which a formula is parsed on the calling thread alone.
+    size_t min_tokens = size_t{ 1 } << 16;
+    /// Number of tokens of operands a worker claims at a time.
+    size_t chunk_tokens = size_t{ 1 } << 12;
+    /// The rule the formula is parsed from; `Rule::DYNAMIC` stands for `Rule::EQUIVALENCE`.
+    Rule entry = Rule::EQUIVALENCE;
+    /// The mapping from tokens to operators.
+    Parser::MappingFunction mappingFunction = &mapToAlethicOperator;
+    /// How deeply the formula may nest (see `ParserBase::setNestingLimit()`).
+    size_t nesting_limit = Parser::default_nesting_limit;
+};
+
+/**
+ * @brief Parses a single long formula across a pool of threads.
+ *
+ * Meant for formulas made of long chains of `↔`, `→`, `∧` and `∨` outside any bracket. After
+ * lexing, the workers find those connectives with a bracket-depth scan over a share of the
+ * tokens each, then parse the operands between them concurrently, each worker with a parser
+ * of its own. The operands are finally combined the way the grammar does, `∧` and `∨` before
+ * `→` before `↔`, each level associating to the left, so the tree is the one `parse()` gives.
+ *
+ * Only `Rule::EQUIVALENCE`, `Rule::IMPLICATION` and `Rule::CONJUNCTION_DISJUNCTION` have
+ * connectives to split at; any other entry rule, a formula shorter than `min_tokens`, or a
+ * single worker, parses on the calling thread. So does any formula that fails: it is parsed
+ * again from the start, so that the error is the one `parse()` reports.
+ *
+ * The mapping function is called from every worker at once, so it must be safe to call
+ * concurrently (the built-in ones are). If a worker throws, the exception is rethrown on the
+ * calling thread.
+ *
+ * Every connective of a chain adds a level to the tree, so the tree of a long chain is too
+ * deep to be destroyed recursively. It comes in an `OwnedExpression`, which destroys it
+ * with `dismantle()`; whoever takes it out with `release()` should let it go the same way.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param options How to split the work, and how to parse the formula.
+ * @return Parsed QML expression or an error message.
+ */
+std::expected<OwnedExpression, std::string> parse_parallel(std::string_view formula, const ParallelOptions& options = {});
+
+}
@@ -8,71 +8,154 @@
 
 #include <expected>
 #include <functional>
+#include <memory_resource>
 #include <optional>
-#include <vector>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <QMLExpression/expression.hpp>
 
+#include "basic_parser.hpp"
+#include "builder.hpp"
+#include "error.hpp"
+#include "flat.hpp"
 #include "lexer.hpp"
 #include "maps.hpp"
+#include "pool.hpp"
+#include "teardown.hpp"
 #include "token.hpp"
 
 namespace iif_sadaf::talk::QMLParser {
 
 /**
- * @class Parser
- * @brief Parses a sequence of tokens into a Quantified Modal Logic (QML) expression tree.
+ * @typedef Parser
+ * @brief The parser whose entry point and mapping are chosen at run time.
  *
- * This class implements a recursive descent parser for QML expressions. It processes a vector
- * of tokens and constructs an abstract syntax tree (AST) representing a well-formed formula.
+ * Both are held in a `std::function`, so any rule and any mapping can be used without
+ * naming them in the type. Where they are known in advance, `BasicParser` with a `Rule` and
+ * one of the functors in maps.hpp avoids the indirection.
  */
-class Parser
-{
-public:
-    /**
-     * @typedef ParseFunction
-     * @brief Defines the function signature for parsing rules.
-     */
-    using ParseFunction = std::function<std::expected<QMLExpression::Expression, std::string>(Parser&)>;
-
-    /**
-     * @typedef MappingFunction
-     * @brief Maps token types to QML logical operators.
-     */
-    using MappingFunction = std::function<std::optional<QMLExpression::Operator>(TokenType)>;
-
-    Parser(const std::vector<Token>& tokens, MappingFunction mapFunc = mapToAlethicOperator);
-    std::expected<QMLExpression::Expression, std::string> parse(ParseFunction entryPoint = &Parser::equivalence);
-
-    // rules
-    std::expected<QMLExpression::Expression, std::string> equivalence();
-    std::expected<QMLExpression::Expression, std::string> implication();
-    std::expected<QMLExpression::Expression, std::string> conjunction_disjunction();
-    std::expected<QMLExpression::Expression, std::string> clause();
-    std::expected<QMLExpression::Expression, std::string> quantificational();
-    std::expected<QMLExpression::Expression, std::string> unary();
-    std::expected<QMLExpression::Expression, std::string> atomic();
-    std::expected<QMLExpression::Expression, std::string> predication();
-    std::expected<QMLExpression::Expression, std::string> identity();
-    std::expected<QMLExpression::Expression, std::string> inequality();
-
-private:
-    void advance();
-    TokenType peek(int offset = 0) const;
-    const Token& getToken(size_t index) const;
-
-    // start rule
-    std::expected<QMLExpression::Expression, std::string> sentence();
-
-    int m_Index;
-    TokenType m_LookAhead;
-    std::vector<Token> m_TokenList;
-    std::function<std::optional<QMLExpression::Operator>(TokenType)> m_MapToOperator;
-    ParseFunction m_EntryPoint = &Parser::equivalence;
-};
+using Parser = BasicParser<std::function<std::optional<QMLExpression::Operator>(TokenType)>, Rule::DYNAMIC>;
+
+extern template class BasicParser<std::function<std::optional<QMLExpression::Operator>(TokenType)>, Rule::DYNAMIC>;
 
+/*
+ * Parsing takes no native stack per level of nesting, but destroying the tree these return
+ * does (see `Parser::parse()`): some 70 KiB for one as deep as the default nesting limit
+ * allows. Where that is too much, `parse_owned()` gives the same tree in an `OwnedExpression`.
+ */
 std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, Parser::ParseFunction entryPoint = &Parser::equivalence, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
 std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, Parser::MappingFunction mappingFunction);
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, std::pmr::memory_resource& arena, Parser::ParseFunction entryPoint = &Parser::equivalence, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Parses `formula` as `parse()` does, into an expression that is destroyed without recursing.
+ *
+ * For threads whose stack is too small to destroy the tree `parse()` returns, such as worker
+ * threads of a few dozen KiB: neither parsing the formula nor letting go of the result takes
+ * native stack per level of the tree (see `OwnedExpression`).
+ *
+ * @param formula The input string representing a QML formula.
+ * @param entryPoint The starting parse rule (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ * @return Parsed QML expression or an error message.
+ */
+std::expected<OwnedExpression, std::string> parse_owned(const std::string& formula, Parser::ParseFunction entryPoint = &Parser::equivalence, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Parses `formula`, sharing every subformula already built through `pool`.
+ *
+ * Gives the same results as `parse()`, but any subformula equal to one built before through
+ * `pool`, in this formula or in an earlier one, is the very same node. `Rule::DYNAMIC`
+ * stands for `Rule::EQUIVALENCE`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param pool The pool to take nodes from and add new ones to.
+ * @param entry The rule to start from (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ * @return Parsed QML expression or an error message.
+ */
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, ExpressionPool& pool, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Parses `formula` into the flat arrays of `into`, after the formulas already there.
+ *
+ * Accepts exactly the formulas `parse()` accepts, with the same error messages, and
+ * `into.expression()` gives the same tree `parse()` does. No node is allocated on its own:
+ * each takes a place in the arrays of `into`. When parsing fails, the nodes of `formula` are
+ * dropped again. `Rule::DYNAMIC` stands for `Rule::EQUIVALENCE`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param into The flat expression to add the formula to.
+ * @param entry The rule to start from (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ * @return The root node of the formula in `into`, or an error message.
+ */
+std::expected<FlatExpression::Index, std::string> parse(const std::string& formula, FlatExpression& into, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Parses `formula`, recording the bytes of it that each node was parsed from.
+ *
+ * Gives the same results as `parse()`. The lexer records where each token is, and the
+ * parser turns the tokens of each node into the bytes of `formula` they span, into `spans`,
+ * whose contents are replaced: `spans[k]` is the span of the k-th node of the tree in
+ * postorder (see `SpanBuilder`). The nodes store nothing more. When parsing fails, `spans`
+ * is left empty. `Rule::DYNAMIC` stands for `Rule::EQUIVALENCE`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param spans The list to fill with the span of each node.
+ * @param entry The rule to start from (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ * @return Parsed QML expression or an error message.
+ */
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, std::vector<SourceSpan>& spans, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Parses `formula` into `into`, recording the bytes of it that each node was parsed from.
+ *
+ * As the other overload for a `FlatExpression`, but `spans[i]`, for every node `i` of
+ * `formula`, is the span of `formula` that node was parsed from. `spans` is first resized to
+ * the nodes already in `into`, so that nodes added without spans get empty ones; when
+ * parsing fails, it is resized back.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param into The flat expression to add the formula to.
+ * @param spans The list of spans by node of `into`, to extend.
+ * @param entry The rule to start from (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ * @return The root node of the formula in `into`, or an error message.
+ */
+std::expected<FlatExpression::Index, std::string> parse(const std::string& formula, FlatExpression& into, std::vector<SourceSpan>& spans, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Tells whether `formula` parses, without producing an error message.
+ *
+ * Accepts exactly the formulas `parse()` accepts, but builds no expression tree, and failures
+ * carry no information, so no text is formatted on the way out. `Rule::DYNAMIC` stands for
+ * `Rule::EQUIVALENCE`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param entry The rule to start from (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ * @return Whether the formula is well formed.
+ */
+bool validate(std::string_view formula, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+/**
+ * @brief Tells whether `formula` is a well-formed QML formula, without building anything.
+ *
+ * Runs the grammar of `Parser` with a `NullBuilder`, so neither an expression tree nor an
+ * error message is produced. Every connective has an operator under the built-in maps, so
+ * the answer is the same for all three. Each thread keeps a few token buffers, of which a
+ * call borrows one while it runs: after the first few calls, nothing is allocated unless a
+ * formula needs more than a megabyte of tokens, whose buffer is then freed rather than
+ * kept. `Rule::DYNAMIC` stands for `Rule::EQUIVALENCE`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param entry The rule to start from (default: equivalence).
+ * @return Whether `parse()` would succeed on `formula` from `entry`.
+ */
+bool is_well_formed(std::string_view formula, Rule entry = Rule::EQUIVALENCE);
 
 }
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "builder.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class ExpressionPool
+ * @brief Keeps a single node for each distinct subformula built through it.
+ *
+ * A `SharingBuilder` looks every node up in the pool before building it. A node is known by
+ * its kind, its operator, the addresses of its children and the names it holds, so any two
+ * equal subformulas built through the same pool are the same node, and comparing pointers
+ * is enough to compare them. The pool holds on to every node it hands out until `clear()`
+ * is called or the pool is destroyed. It must not be used by two threads at once.
+ */
+class ExpressionPool
+{
+public:
+    size_t size() const;
+    void clear();
+
+private:
+    friend struct SharingBuilder;
+
+    enum class Kind : unsigned char { UNARY, BINARY, QUANTIFICATION, IDENTITY, PREDICATION };
+
+    struct KeyView {
+        Kind kind;
+        int tag;
+        const void* first;
+        const void* second;
+        std::string_view text;
+    };
+
+    struct Key {
+        Kind kind;
+        int tag;
+        const void* first;
+        const void* second;
+        std::string text;
+    };
+
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(const KeyView& key) const;
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Equal {
+        using is_transparent = void;
+        template<typename Lhs, typename Rhs>
+        bool operator()(const Lhs& lhs, const Rhs& rhs) const
+        {
+            const KeyView l = view(lhs);
+            const KeyView r = view(rhs);
+            return l.kind == r.kind && l.tag == r.tag && l.first == r.first && l.second == r.second && l.text == r.text;
+        }
+    };
+
+    static KeyView view(const KeyView& key)
+    {
+        return key;
+    }
+
+    static KeyView view(const Key& key)
+    {
+        return { key.kind, key.tag, key.first, key.second, key.text };
+    }
+
+    template<typename Make>
+    QMLExpression::Expression intern(const KeyView& key, Make&& make);
+
+    std::unordered_map<Key, QMLExpression::Expression, Hash, Equal> m_Nodes;
+    // The names of the node being looked up, so that a hit allocates nothing.
+    std::string m_Text;
+    // The terms of the argument list being parsed.
+    std::vector<std::pair<std::string_view, TokenType>> m_Arguments;
+    ExpressionBuilder m_Builder;
+};
+
+/**
+ * @struct SharingBuilder
+ * @brief Builds the expression tree out of the nodes of an `ExpressionPool`.
+ *
+ * Terms and argument lists are kept as views of the tokens, and only copied when the node
+ * they go into is not in the pool yet.
+ */
+struct SharingBuilder {
+    using Value = QMLExpression::Expression;
+
+    struct TermValue {
+        std::string_view literal;
+        TokenType type;
+    };
+
+    struct Arguments {};
+
+    explicit SharingBuilder(ExpressionPool& pool);
+
+    TermValue term(std::string_view literal, TokenType type) const
+    {
+        return { literal, type };
+    }
+
+    Arguments arguments(size_t count) const;
+    void argument(Arguments& arguments, TermValue term) const;
+    Value unary(QMLExpression::Operator op, Value scope) const;
+    Value binary(QMLExpression::Operator op, Value lhs, Value rhs) const;
+    Value quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const;
+    Value identity(TermValue lhs, TermValue rhs) const;
+    Value predication(std::string_view predicate, Arguments arguments) const;
+
+private:
+    ExpressionPool* m_Pool;
+};
+
+// Returns the node known by `key`, building it with `make` if there is none yet.
+template<typename Make>
+QMLExpression::Expression ExpressionPool::intern(const KeyView& key, Make&& make)
+{
+    if (const auto node = m_Nodes.find(key); node != m_Nodes.end()) {
+        return node->second;
+    }
+
+    QMLExpression::Expression expression = std::forward<Make>(make)();
+    m_Nodes.emplace(Key{ key.kind, key.tag, key.first, key.second, std::string(key.text) }, expression);
+    return expression;
+}
+
+}
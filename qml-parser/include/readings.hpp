@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <array>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <QMLExpression/expression.hpp>
+
+#include "basic_parser.hpp"
+#include "maps.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class ModalReadings
+ * @brief Holds a formula parsed once, and gives its reading under each modality.
+ *
+ * The three built-in mappings only differ on what the box and the diamond stand for, so
+ * the tree parsed under one of them is turned into the others by `relabel()`. Each reading
+ * is built the first time it is asked for and kept after that. This class is not safe to
+ * use from several threads at once.
+ */
+class ModalReadings
+{
+public:
+    explicit ModalReadings(QMLExpression::Expression alethic);
+
+    const QMLExpression::Expression& reading(Modality modality);
+
+private:
+    std::array<std::optional<QMLExpression::Expression>, 3> m_Readings;
+};
+
+/**
+ * @brief Lexes and parses `formula` once, for reading under any modality.
+ *
+ * Accepts exactly the formulas `parse()` accepts, with the same error messages, which do
+ * not depend on the mapping. `Rule::DYNAMIC` stands for `Rule::EQUIVALENCE`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param entry The rule to start from (default: equivalence).
+ * @return The readings of the formula, or an error message.
+ */
+std::expected<ModalReadings, std::string> parse_readings(std::string_view formula, Rule entry = Rule::EQUIVALENCE);
+
+/**
+ * @brief Turns every modal operator of `expression` into the one of `modality`.
+ *
+ * Necessity becomes the necessity of `modality`, and possibility its possibility, whatever
+ * modality they were in. Only the nodes on the way from a modal operator to the root are
+ * rebuilt; every subformula without modal operators is shared with `expression`. The tree
+ * is walked without recursion, however deep it is.
+ *
+ * @param expression The expression to relabel.
+ * @param modality The modality to read the box and the diamond in.
+ * @return The relabeled expression, or `expression` itself if nothing changes.
+ */
+QMLExpression::Expression relabel(const QMLExpression::Expression& expression, Modality modality);
+
+}
@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "error.hpp"
+#include "maps.hpp"
+#include "parser.hpp"
+#include "teardown.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @struct Diagnostic
+ * @brief One error found by `parse_recovering()`.
+ *
+ * The parser skipped the tokens from `begin` up to `end` to get past the error; `end` equals
+ * `begin` where it skipped none.
+ */
+struct Diagnostic {
+    /// What went wrong.
+    ErrorCode code = ErrorCode::NO_MATCH;
+    /// The index of the offending token.
+    size_t begin = 0;
+    /// The index of the token the parser went on from.
+    size_t end = 0;
+    /// The text of the error, as `ParseError::message()` gives it.
+    std::string message;
+};
+
+/**
+ * @struct RecoveredParse
+ * @brief What `parse_recovering()` makes of a formula.
+ */
+struct RecoveredParse {
+    /// Whether the formula parsed without errors.
+    bool ok() const
+    {
+        return diagnostics.empty();
+    }
+
+    /// The parts of the formula that did parse; nothing if none did. No nesting limit applies,
+    /// so the expression is held in an `OwnedExpression`, which destroys it without recursing.
+    std::optional<OwnedExpression> expression = {};
+    /// Every error found, in input order.
+    std::vector<Diagnostic> diagnostics = {};
+};
+
+/**
+ * @brief Parses a formula, going on past every error instead of stopping at the first.
+ *
+ * Meant for validating many formulas at once, where each formula should cost one pass no
+ * matter how many errors it has. The formula is read once from left to right. At an error,
+ * the parser records a diagnostic and skips ahead in panic mode: to the next `,` within an
+ * argument list, and otherwise to the next `)`, `]`, or connective the entry rule parses
+ * outside the brackets the error is in. Closing brackets end the bracket they are found in,
+ * mismatched or not, and brackets left open are closed at the end of the input.
+ *
+ * The expression holds what could be parsed. A construct missing a part, or whose operator
+ * the mapping lacks, is left out: a connective gives just the operand it has on its left
+ * (or its right one, if that is all it has), and a prefix goes along with its scope. A
+ * formula without errors gives the expression `parse()` gives. Otherwise the first
+ * diagnostic is the error `parse()` reports, except that a variable followed by '(' is
+ * reported as an unexpected token, where `parse()` has no message; later diagnostics may
+ * follow from earlier ones.
+ *
+ * Only `Rule::EQUIVALENCE`, `Rule::IMPLICATION`, `Rule::CONJUNCTION_DISJUNCTION` and
+ * `Rule::CLAUSE` are recovered from, `Rule::DYNAMIC` standing for `Rule::EQUIVALENCE`; any
+ * other entry rule stops at the first error, as `parse()` does. The prefixes and brackets
+ * open are kept on the heap, so no nesting limit applies, and however deep the expression
+ * is, neither parsing it nor destroying the result recurses.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param entry The rule the formula is parsed from.
+ * @param mappingFunction The mapping from tokens to operators.
+ * @return The partial expression and the diagnostics.
+ */
+RecoveredParse parse_recovering(std::string_view formula, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+}
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @brief Encodes `expressions` in the binary format read by `ExpressionArchive`.
+ *
+ * The format is versioned; this writes version `ExpressionArchive::version`. It holds:
+ * - a header, with a magic number, the version and the size of each section;
+ * - the index of the root node of each expression, in the order given;
+ * - every node, in postorder, so that each node only refers to nodes before it;
+ * - the argument lists of the predications;
+ * - every distinct name, once.
+ *
+ * A node reached twice, from one expression or from several, is written once, and so is each
+ * distinct term, so the trees of an `ExpressionPool` stay shared. Every number is a 32-bit
+ * little-endian integer, whatever the host.
+ *
+ * @param expressions The expressions to encode.
+ * @return The encoding.
+ * @throws std::length_error if there are more nodes or names than 32 bits can number.
+ */
+std::vector<std::byte> serialize(std::span<const QMLExpression::Expression> expressions);
+
+/**
+ * @class ExpressionArchive
+ * @brief Reads the expressions encoded by `serialize()`, straight from the bytes.
+ *
+ * The bytes are checked once, when the archive is opened; after that, nothing in them is
+ * copied. They are not required to be aligned, so a file can be read into memory or mapped
+ * as it is, and must outlive the archive and every `Node` taken from it.
+ *
+ * The nodes can be walked in place through `root()`, or turned back into
+ * `QMLExpression::Expression` trees by `expressions()` or `expression()`.
+ */
+class ExpressionArchive
+{
+public:
+    /// The version of the format that `serialize()` writes and `open()` reads.
+    static constexpr uint32_t version = 1;
+
+    enum class Kind : uint8_t { TERM, UNARY, BINARY, QUANTIFICATION, IDENTITY, PREDICATION };
+
+    /**
+     * @class Node
+     * @brief A node of the archive, read in place.
+     *
+     * What a node holds depends on its kind:
+     * - `TERM`: `name()` and `termType()`;
+     * - `UNARY`: `op()` and its scope as `child(0)`;
+     * - `BINARY`: `op()` and its sides as `child(0)` and `child(1)`;
+     * - `QUANTIFICATION`: `quantifier()`, its variable, a term, as `child(0)`, and its scope as `child(1)`;
+     * - `IDENTITY`: its terms as `child(0)` and `child(1)`;
+     * - `PREDICATION`: the predicate as `name()`, and its `arity()` terms as `child(0)` and on.
+     */
+    class Node
+    {
+    public:
+        Kind kind() const;
+        QMLExpression::Operator op() const;
+        QMLExpression::Quantifier quantifier() const;
+        QMLExpression::Term::Type termType() const;
+        std::string_view name() const;
+        size_t arity() const;
+        Node child(size_t i) const;
+
+    private:
+        friend class ExpressionArchive;
+        Node(const ExpressionArchive* archive, uint32_t index);
+
+        const ExpressionArchive* m_Archive;
+        uint32_t m_Index;
+    };
+
+    static std::expected<ExpressionArchive, std::string> open(std::span<const std::byte> bytes);
+
+    size_t size() const;
+    Node root(size_t i) const;
+
+    std::vector<QMLExpression::Expression> expressions(std::pmr::memory_resource* resource = nullptr) const;
+    QMLExpression::Expression expression(size_t i, std::pmr::memory_resource* resource = nullptr) const;
+
+private:
+    ExpressionArchive() = default;
+
+    uint32_t word(size_t offset) const;
+    uint32_t nodeField(uint32_t node, size_t field) const;
+    uint32_t argument(uint32_t node, size_t i) const;
+    std::string_view symbol(uint32_t symbol) const;
+
+    std::span<const std::byte> m_Bytes;
+    uint32_t m_ExpressionCount = 0;
+    uint32_t m_NodeCount = 0;
+    uint32_t m_ArgumentCount = 0;
+    uint32_t m_SymbolCount = 0;
+    // Where each section starts.
+    size_t m_Roots = 0;
+    size_t m_Nodes = 0;
+    size_t m_Arguments = 0;
+    size_t m_Offsets = 0;
+    size_t m_Names = 0;
+};
+
+}
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QMLExpression/expression.hpp>
+
+#include "maps.hpp"
+#include "parser.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @class ParseSession
+ * @brief Keeps a formula parsed while it is being edited.
+ *
+ * Each edit replaces a range of the text. Only the tokens around the edit are lexed again:
+ * lexing resumes a token before it, and stops as soon as it falls back in step with the
+ * old tokens after it, and those tokens are spliced into the ones the parser reads. The
+ * parse that follows takes up from the last connective outside of every bracket that comes
+ * before the edit, with the left-hand sides parsed last time, and skips every clause whose
+ * tokens the edit left alone, reusing its subtree. What is parsed again is thus the clause
+ * the edit falls in, down to the innermost bracket enclosing it, and what is built again is
+ * one node for each connective between it and the root: the tree is shared with earlier
+ * results, so the nodes above the edit cannot be changed in place.
+ *
+ * The tokens are those of `lex_view()`, and the result is that of a `Parser` over them,
+ * which matches `parse()` on well-formed input.
+ */
+class ParseSession
+{
+public:
+    using Result = std::expected<QMLExpression::Expression, std::string>;
+
+    explicit ParseSession(std::string_view text = {}, Rule entry = Rule::EQUIVALENCE, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+    const Result& edit(size_t offset, size_t erased, std::string_view inserted);
+
+    const Result& result() const;
+    std::string_view text() const;
+
+private:
+    // A token, as a range of the text, which moves as the text is edited.
+    struct Span {
+        size_t begin = 0;
+        size_t length = 0;
+        TokenType type = TokenType::NIL;
+    };
+
+    size_t position(size_t index) const;
+    void relex(size_t offset, size_t erased, size_t inserted);
+    void forget(size_t first);
+    void reparse();
+
+    std::string m_Text;
+    Rule m_Entry;
+    Parser::MappingFunction m_MappingFunction;
+
+    // The tokens up to EOI. Those from m_ShiftFrom on begin m_Shift bytes past where they
+    // say, so that an edit only moves the tokens between it and the one before.
+    std::vector<Span> m_Tokens;
+    size_t m_ShiftFrom = 0;
+    size_t m_Shift = 0;
+    std::vector<Span> m_Fresh;
+
+    // What the parser reads: the tokens copied out of m_Text, EOI included, and the clauses
+    // and prefixes it recorded, which it reuses.
+    TokenBuffer m_Lexed;
+    TokenBuffer m_FreshLexed;
+    std::vector<Parser::Group> m_Groups;
+    std::vector<Parser::Prefix> m_Prefixes;
+
+    Result m_Result;
+};
+
+}
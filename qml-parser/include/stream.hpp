@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <concepts>
+#include <expected>
+#include <istream>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <QMLExpression/expression.hpp>
+
+#include "generator.hpp"
+#include "maps.hpp"
+#include "parser.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace detail {
+    template <typename Formulas>
+    Generator<std::expected<QMLExpression::Expression, std::string>> parseEach(Formulas formulas, Parser::ParseFunction entryPoint, Parser::MappingFunction mappingFunction)
+    {
+        Parser parser(std::move(mappingFunction));
+        for (auto&& formula : formulas) {
+            std::expected<QMLExpression::Expression, std::string> result;
+            {
+                // Closed before yielding, so that the counters of a formula are never left pending.
+                const StatsScope scope;
+                parser.reset(std::string_view(formula));
+                result = parser.parse(entryPoint);
+            }
+            co_yield std::move(result);
+        }
+    }
+}
+
+/**
+ * @brief Parses a sequence of formulas lazily, one at a time.
+ *
+ * Yields what `parse()` gives for each formula, in order, but parses it only when it is
+ * asked for, with a single parser whose token buffer is reused from one formula to the
+ * next. Stopping early leaves the remaining formulas unparsed.
+ *
+ * A range given as an lvalue is referred to, and must outlive the generator; one given as
+ * an rvalue is moved into it.
+ *
+ * @param formulas A range of formulas, each convertible to `std::string_view`.
+ * @param entryPoint The rule every formula is parsed from.
+ * @param mappingFunction The mapping from tokens to operators used for every formula.
+ * @return A generator of results.
+ */
+template <std::ranges::viewable_range Formulas>
+    requires std::ranges::input_range<Formulas> && std::convertible_to<std::ranges::range_reference_t<Formulas>, std::string_view>
+Generator<std::expected<QMLExpression::Expression, std::string>> parse_each(Formulas&& formulas, Parser::ParseFunction entryPoint = &Parser::equivalence, Parser::MappingFunction mappingFunction = &mapToAlethicOperator)
+{
+    return detail::parseEach(std::views::all(std::forward<Formulas>(formulas)), std::move(entryPoint), std::move(mappingFunction));
+}
+
+/**
+ * @brief Parses the formulas of a stream lazily, one per line.
+ *
+ * Reads a line only when the previous result has been consumed, so memory use is bounded
+ * by the longest line, whatever the size of the stream. Lines may end in `\n` or `\r\n`;
+ * empty lines are skipped. `input` must outlive the generator.
+ *
+ * @param input The stream to read the formulas from.
+ * @param entryPoint The rule every formula is parsed from.
+ * @param mappingFunction The mapping from tokens to operators used for every formula.
+ * @return A generator of results.
+ */
+Generator<std::expected<QMLExpression::Expression, std::string>> parse_each(std::istream& input, Parser::ParseFunction entryPoint = &Parser::equivalence, Parser::MappingFunction mappingFunction = &mapToAlethicOperator);
+
+}
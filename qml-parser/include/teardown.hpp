@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <utility>
+
+#include <QMLExpression/expression.hpp>
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @brief Destroys an expression tree without recursing once per level.
+ *
+ * Letting the last owner of a tree go destroys it node by node, each node destroying its
+ * children before it returns, so the native stack grows with the depth of the tree. This
+ * function moves the operands out of each node before the node is destroyed, and keeps the
+ * nodes still to be destroyed on a heap-allocated stack, so however deep the tree is, the
+ * native stack stays flat. Nodes also held by other expressions are left to them. Should
+ * that stack fail to grow, the operands it would hold are destroyed recursively instead.
+ *
+ * @param expression The expression to destroy.
+ */
+void dismantle(QMLExpression::Expression&& expression) noexcept;
+
+/**
+ * @class OwnedExpression
+ * @brief Holds an expression, and destroys it with `dismantle()` when it goes.
+ *
+ * For expressions that may be too deep to destroy recursively, such as the long chains of
+ * connectives `parse_parallel()` is meant for. Copies share the nodes of the expression, as
+ * copies of a `QMLExpression::Expression` do.
+ */
+class OwnedExpression
+{
+public:
+    OwnedExpression(QMLExpression::Expression expression)
+        : m_Expression(std::move(expression))
+    {
+    }
+
+    OwnedExpression(const OwnedExpression&) = default;
+    OwnedExpression(OwnedExpression&&) noexcept = default;
+    OwnedExpression& operator=(const OwnedExpression& other);
+    OwnedExpression& operator=(OwnedExpression&& other) noexcept;
+    ~OwnedExpression();
+
+    const QMLExpression::Expression& get() const { return m_Expression; }
+    const QMLExpression::Expression& operator*() const { return m_Expression; }
+    const QMLExpression::Expression* operator->() const { return &m_Expression; }
+
+    /// Hands the expression over, leaving its destruction to the caller.
+    QMLExpression::Expression release() &&;
+
+private:
+    QMLExpression::Expression m_Expression;
+};
+
+}
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "workers.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    using Result = std::expected<QMLExpression::Expression, std::string>;
+
+    /*
+     * The formulas of one worker. The owner and thieves claim chunks the same way, by
+     * bumping `next`, so a formula is never handed out twice.
+     */
+    struct alignas(64) Range {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    class Batch
+    {
+    public:
+        Batch(std::span<const std::string_view> formulas, std::span<Result> results, const BatchOptions& options, size_t workers)
+            : m_Formulas(formulas), m_Results(results), m_Options(options), m_Ranges(workers)
+        {
+            const size_t share = formulas.size() / workers;
+            const size_t rest = formulas.size() % workers;
+            size_t begin = 0;
+            for (size_t i = 0; i < workers; ++i) {
+                const size_t end = begin + share + (i < rest ? 1 : 0);
+                m_Ranges[i].next.store(begin, std::memory_order_relaxed);
+                m_Ranges[i].end = end;
+                begin = end;
+            }
+        }
+
+        void work(size_t self)
+        {
+            // The parser is reset for every formula and keeps its buffers.
+            Parser parser(m_Options.mappingFunction);
+            parser.setNestingLimit(m_Options.nesting_limit);
+
+            for (size_t k = 0; k < m_Ranges.size() && !m_Failed.load(std::memory_order_relaxed); ++k) {
+                Range& range = m_Ranges[(self + k) % m_Ranges.size()];
+                while (!m_Failed.load(std::memory_order_relaxed)) {
+                    const size_t begin = range.next.fetch_add(m_Options.chunk_size, std::memory_order_relaxed);
+                    if (begin >= range.end) {
+                        break;
+                    }
+                    const size_t end = std::min(begin + m_Options.chunk_size, range.end);
+                    for (size_t i = begin; i < end; ++i) {
+                        m_Results[i] = parseOne(parser, m_Formulas[i], m_Options.entryPoint);
+                    }
+                }
+            }
+        }
+
+        // Makes the other workers give up the formulas they have not reached.
+        void fail()
+        {
+            m_Failed.store(true, std::memory_order_relaxed);
+        }
+
+    private:
+        static Result parseOne(Parser& parser, std::string_view formula, const Parser::ParseFunction& entryPoint)
+        {
+            const detail::StatsScope scope;
+            parser.reset(formula);
+            return parser.parse(entryPoint);
+        }
+
+        std::span<const std::string_view> m_Formulas;
+        std::span<Result> m_Results;
+        const BatchOptions& m_Options;
+        std::vector<Range> m_Ranges;
+        std::atomic<bool> m_Failed = false;
+    };
+}
+
+std::vector<std::expected<QMLExpression::Expression, std::string>> parse_batch(std::span<const std::string_view> formulas, const BatchOptions& options)
+{
+    std::vector<Result> results(formulas.size(), std::unexpected(std::string()));
+    if (formulas.empty()) {
+        return results;
+    }
+
+    const size_t chunk_size = std::max<size_t>(options.chunk_size, 1);
+    const size_t chunks = (formulas.size() + chunk_size - 1) / chunk_size;
+    const size_t workers = detail::workerCount(options.threads, chunks);
+
+    BatchOptions effective = options;
+    effective.chunk_size = chunk_size;
+    Batch batch(formulas, results, effective, workers);
+    detail::spread(workers, [&batch](size_t i) { batch.work(i); }, [&batch] { batch.fail(); });
+    return results;
+}
+
+}
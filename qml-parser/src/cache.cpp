@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "cache.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "parser.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    Parser::MappingFunction mappingFor(Modality modality)
+    {
+        switch (modality) {
+        case Modality::DEONTIC: return &mapToDeonticOperator;
+        case Modality::EPISTEMIC: return &mapToEpistemicOperator;
+        default: return &mapToAlethicOperator;
+        }
+    }
+}
+
+/**
+ * @brief Constructs an empty cache.
+ * @param capacity The number of results to keep at most; 0 keeps none.
+ * @param shards The number of independently locked parts to split the cache into.
+ */
+ParseCache::ParseCache(size_t capacity, size_t shards)
+    : m_ShardCount(std::clamp<size_t>(shards, 1, std::max<size_t>(capacity, 1))),
+      m_Hits(0), m_Misses(0), m_Evictions(0)
+{
+    m_Shards = std::make_unique<Shard[]>(m_ShardCount);
+    for (size_t i = 0; i < m_ShardCount; ++i) {
+        m_Shards[i].capacity = capacity / m_ShardCount + (i < capacity % m_ShardCount ? 1 : 0);
+    }
+}
+
+ParseCache::~ParseCache() = default;
+
+/**
+ * @brief Parses `formula`, or returns the result of an earlier parse of it.
+ *
+ * Gives the same result as `parse()` with the entry rule `entry` and the built-in mapping
+ * for `modality`.
+ *
+ * @param formula The input string representing a QML formula.
+ * @param entry The rule to start from (default: equivalence).
+ * @param modality Which modal operators the box and diamond stand for (default: alethic).
+ * @return Parsed QML expression or an error message.
+ */
+auto ParseCache::parse(std::string_view formula, Rule entry, Modality modality) -> Result
+{
+    const KeyView key{ formula, entry, modality };
+    Shard& shard = shardFor(Hash{}(key));
+
+    {
+        const std::lock_guard lock(shard.mutex);
+        if (const auto found = shard.index.find(key); found != shard.index.end()) {
+            shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+            m_Hits.fetch_add(1, std::memory_order_relaxed);
+            return found->second->result;
+        }
+    }
+
+    m_Misses.fetch_add(1, std::memory_order_relaxed);
+
+    std::string text(formula);
+    Result result = QMLParser::parse(text, Parser::entryPointFor(entry), mappingFor(modality));
+
+    if (shard.capacity == 0) {
+        return result;
+    }
+
+    const std::lock_guard lock(shard.mutex);
+
+    // Another thread may have parsed the same formula in the meantime.
+    if (shard.index.contains(key)) {
+        return result;
+    }
+
+    if (shard.entries.size() >= shard.capacity) {
+        const Entry& last = shard.entries.back();
+        shard.index.erase(KeyView{ last.formula, last.entry, last.modality });
+        shard.entries.pop_back();
+        m_Evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.entries.push_front({ std::move(text), entry, modality, result });
+    const Entry& stored = shard.entries.front();
+    shard.index.emplace(KeyView{ stored.formula, stored.entry, stored.modality }, shard.entries.begin());
+
+    return result;
+}
+
+/**
+ * @brief Gives the hit, miss and eviction counts so far.
+ *
+ * The counts are read one at a time, so while other threads use the cache they need not
+ * add up exactly.
+ */
+CacheStats ParseCache::stats() const
+{
+    return { m_Hits.load(std::memory_order_relaxed), m_Misses.load(std::memory_order_relaxed), m_Evictions.load(std::memory_order_relaxed) };
+}
+
+/**
+ * @brief Gives the number of results in the cache.
+ */
+size_t ParseCache::size() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < m_ShardCount; ++i) {
+        const std::lock_guard lock(m_Shards[i].mutex);
+        total += m_Shards[i].entries.size();
+    }
+    return total;
+}
+
+/**
+ * @brief Drops every result; the counters are kept.
+ */
+void ParseCache::clear()
+{
+    for (size_t i = 0; i < m_ShardCount; ++i) {
+        const std::lock_guard lock(m_Shards[i].mutex);
+        m_Shards[i].index.clear();
+        m_Shards[i].entries.clear();
+    }
+}
+
+size_t ParseCache::Hash::operator()(const KeyView& key) const
+{
+    const size_t hash = std::hash<std::string_view>{}(key.formula);
+    return hash ^ ((static_cast<size_t>(key.entry) << 4 | static_cast<size_t>(key.modality)) * 0x9e3779b97f4a7c15ULL);
+}
+
+bool ParseCache::Equal::operator()(const KeyView& lhs, const KeyView& rhs) const
+{
+    return lhs.entry == rhs.entry && lhs.modality == rhs.modality && lhs.formula == rhs.formula;
+}
+
+ParseCache::Shard& ParseCache::shardFor(size_t hash)
+{
+    // The low bits pick the bucket inside the shard, so the shard is picked by the high ones.
+    return m_Shards[(hash >> (sizeof(size_t) * 8 - 16)) % m_ShardCount];
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "error.hpp"
+
+#include <format>
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    std::string_view connectiveSymbol(TokenType type)
+    {
+        switch (type) {
+        case TokenType::EQ: return "↔";
+        case TokenType::IF: return "→";
+        case TokenType::AND: return "∧";
+        case TokenType::OR: return "∨";
+        default: return "";
+        }
+    }
+
+    std::string_view operatorName(TokenType type)
+    {
+        switch (type) {
+        case TokenType::EQ: return "EQ (↔)";
+        case TokenType::IF: return "IMP (→)";
+        case TokenType::AND: return "AND (∧)";
+        case TokenType::OR: return "OR (∨)";
+        case TokenType::NOT: return "NOT (¬)";
+        case TokenType::POS: return "POS (⋄)";
+        case TokenType::NEC: return "NEC (□)";
+        default: return "";
+        }
+    }
+
+    std::string describe(const ParseError& error)
+    {
+        switch (error.code) {
+        case ErrorCode::NO_MATCH:
+            return "";
+        case ErrorCode::EMPTY_INPUT:
+            return "Empty input string, nothing to do";
+        case ErrorCode::UNEXPECTED_SYMBOL:
+            return std::format("Unexpected symbol ({})", error.found);
+        case ErrorCode::UNEXPECTED_TOKEN:
+            return std::format("Unexpected token ({})", error.found);
+        case ErrorCode::MISSING_MAP:
+            return std::format("Non-existent map for token type {}", operatorName(error.actual));
+        case ErrorCode::MISSING_UNARY_MAP:
+            return std::format("Non-existent map for unary operator {}", operatorName(error.actual));
+        case ErrorCode::EXPECTED_CLOSING:
+            return std::format("Expected '{}' after '{}' but got '{}'", error.expected == TokenType::RBRACKET ? "]" : ")", error.context, error.found);
+        case ErrorCode::EXPECTED_VARIABLE:
+            return std::format("Expected variable after '{}' but got '{}'", error.context, error.found);
+        case ErrorCode::EXPECTED_CLAUSE:
+            return std::format("Expected clause after unary operator {}", operatorName(error.actual));
+        case ErrorCode::EXPECTED_ATOMIC_OPERATOR:
+            return std::format("Expected '(', '=', or '≠' after '{}' but got '{}'", error.context, error.found);
+        case ErrorCode::EXPECTED_TERM:
+            return std::format("Expected term after '{}' but got '{}'", error.context, error.found);
+        case ErrorCode::EXPECTED_SEPARATOR:
+            return std::format("Expected ',' or ')' after term '{}' but got '{}'", error.context, error.found);
+        case ErrorCode::EXPECTED_ARGUMENT_LIST_END:
+            return std::format("Expected ')' after argument list but got '{}'", error.found);
+        case ErrorCode::EXPECTED_RHS_TERM:
+            return std::format("Expected singular term in RHS of '{}' but got '{}'", error.context, error.found);
+        case ErrorCode::NESTING_TOO_DEEP:
+            return std::format("Nesting limit exceeded at '{}'", error.found);
+        }
+        return "";
+    }
+
+    void prependConnective(std::string& message, TokenType op)
+    {
+        message = std::format("Expected clause after '{}' but got : {}", connectiveSymbol(op), message);
+    }
+}
+
+/**
+ * @brief Formats the error as text.
+ * @return The message the `Parser` reports for this error.
+ */
+std::string ParseError::message() const
+{
+    std::string text = describe(*this);
+    for (const TokenType op : operators) {
+        prependConnective(text, op);
+    }
+    return text;
+}
+
+std::string ErrorTraits<std::string>::make(ParseError&& error)
+{
+    return error.message();
+}
+
+void ErrorTraits<std::string>::wrap(std::string& error, TokenType op)
+{
+    prependConnective(error, op);
+}
+
+}
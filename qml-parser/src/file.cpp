@@ -0,0 +1,286 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "workers.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @brief Maps the whole of `path` into memory.
+ * @param path The file to map.
+ * @throws std::system_error if the file cannot be opened or mapped.
+ */
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot open " + path.string());
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        const DWORD error = GetLastError();
+        CloseHandle(file);
+        throw std::system_error(static_cast<int>(error), std::system_category(), "Cannot read the size of " + path.string());
+    }
+
+    m_Size = static_cast<size_t>(size.QuadPart);
+    if (m_Size != 0) {
+        const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const DWORD error = mapping == nullptr ? GetLastError() : 0;
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            throw std::system_error(static_cast<int>(error), std::system_category(), "Cannot map " + path.string());
+        }
+
+        m_Data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        const DWORD viewError = m_Data == nullptr ? GetLastError() : 0;
+        CloseHandle(mapping);
+        if (m_Data == nullptr) {
+            throw std::system_error(static_cast<int>(viewError), std::system_category(), "Cannot map " + path.string());
+        }
+    }
+    else {
+        CloseHandle(file);
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path.string());
+    }
+
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot read the size of " + path.string());
+    }
+
+    m_Size = static_cast<size_t>(status.st_size);
+    if (m_Size != 0) {
+        void* data = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "Cannot map " + path.string());
+        }
+        // Only a hint: the file is read front to back, chunk by chunk.
+        ::madvise(data, m_Size, MADV_SEQUENTIAL);
+        m_Data = static_cast<const std::byte*>(data);
+    }
+    else {
+        ::close(fd);
+    }
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_Data(std::exchange(other.m_Data, nullptr)), m_Size(std::exchange(other.m_Size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+    }
+    return *this;
+}
+
+/**
+ * @brief Gives the contents of the file.
+ */
+std::span<const std::byte> MappedFile::bytes() const
+{
+    return { m_Data, m_Size };
+}
+
+/**
+ * @brief Gives the contents of the file, as text.
+ */
+std::string_view MappedFile::text() const
+{
+    return { reinterpret_cast<const char*>(m_Data), m_Size };
+}
+
+void MappedFile::unmap()
+{
+    if (m_Data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+#else
+    ::munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+namespace {
+    constexpr size_t not_ready = std::numeric_limits<size_t>::max();
+
+    /*
+     * Chunk i holds the lines that start within its `chunk_bytes` of the file. Workers claim
+     * chunks in order, count the lines of theirs, and hand the count on, so that each chunk
+     * learns the number of its first line from the one before without the file being read
+     * twice.
+     */
+    class FileJob
+    {
+    public:
+        FileJob(std::string_view text, const std::function<void(FileRecord&)>& callback, const FileOptions& options, size_t chunks)
+            : m_Text(text), m_Callback(callback), m_Options(options), m_Chunks(chunks), m_FirstLines(chunks + 1)
+        {
+            m_FirstLines[0].store(1, std::memory_order_relaxed);
+            for (size_t i = 1; i <= chunks; ++i) {
+                m_FirstLines[i].store(not_ready, std::memory_order_relaxed);
+            }
+        }
+
+        void work()
+        {
+            Parser parser(m_Options.mappingFunction);
+            parser.setNestingLimit(m_Options.nesting_limit);
+
+            for (;;) {
+                const size_t chunk = m_Next.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= m_Chunks) {
+                    break;
+                }
+                parseChunk(chunk, parser, m_Options.entryPoint);
+            }
+        }
+
+        // Makes the other workers stop, releasing whoever waits on a chunk the failed one will not reach.
+        void fail()
+        {
+            m_Failed.store(true, std::memory_order_relaxed);
+            for (std::atomic<size_t>& first : m_FirstLines) {
+                first.store(0, std::memory_order_release);
+                first.notify_all();
+            }
+        }
+
+        size_t parsed() const
+        {
+            return m_Parsed.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // Where the first line starting at or after `position` begins.
+        size_t lineStart(size_t position) const
+        {
+            if (position == 0) {
+                return 0;
+            }
+            if (position >= m_Text.size()) {
+                return m_Text.size();
+            }
+            const size_t newline = m_Text.find('\n', position - 1);
+            return newline == std::string_view::npos ? m_Text.size() : newline + 1;
+        }
+
+        void parseChunk(size_t chunk, Parser& parser, const Parser::ParseFunction& entryPoint)
+        {
+            const size_t begin = lineStart(chunk * m_Options.chunk_bytes);
+            const size_t end = lineStart((chunk + 1) * m_Options.chunk_bytes);
+            const std::string_view text = m_Text.substr(begin, end - begin);
+
+            // Every line of the chunk ends in a newline, except perhaps the last line of the file.
+            const size_t newlines = static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+            size_t line = m_FirstLines[chunk].load(std::memory_order_acquire);
+            while (line == not_ready) {
+                m_FirstLines[chunk].wait(not_ready, std::memory_order_acquire);
+                line = m_FirstLines[chunk].load(std::memory_order_acquire);
+            }
+            m_FirstLines[chunk + 1].store(line + newlines, std::memory_order_release);
+            m_FirstLines[chunk + 1].notify_all();
+
+            size_t parsed = 0;
+            for (size_t position = 0; position < text.size() && !m_Failed.load(std::memory_order_relaxed); ++line) {
+                const size_t newline = std::min(text.find('\n', position), text.size());
+                std::string_view formula = text.substr(position, newline - position);
+                const size_t offset = begin + position;
+                position = newline + 1;
+
+                if (!formula.empty() && formula.back() == '\r') {
+                    formula.remove_suffix(1);
+                }
+                if (formula.empty()) {
+                    continue;
+                }
+
+                const detail::StatsScope scope;
+                parser.reset(formula);
+                FileRecord record{ .line = line, .offset = offset, .formula = formula, .result = parser.parse(entryPoint) };
+                m_Callback(record);
+                ++parsed;
+            }
+            m_Parsed.fetch_add(parsed, std::memory_order_relaxed);
+        }
+
+        std::string_view m_Text;
+        const std::function<void(FileRecord&)>& m_Callback;
+        const FileOptions& m_Options;
+        size_t m_Chunks;
+        std::atomic<size_t> m_Next = 0;
+        // The number of the first line of each chunk, once known.
+        std::vector<std::atomic<size_t>> m_FirstLines;
+        std::atomic<size_t> m_Parsed = 0;
+        std::atomic<bool> m_Failed = false;
+    };
+}
+
+size_t parse_file(const std::filesystem::path& path, const std::function<void(FileRecord&)>& callback, const FileOptions& options)
+{
+    const MappedFile file(path);
+    const std::string_view text = file.text();
+    if (text.empty()) {
+        return 0;
+    }
+
+    FileOptions effective = options;
+    effective.chunk_bytes = std::max<size_t>(options.chunk_bytes, 1);
+    const size_t chunks = (text.size() + effective.chunk_bytes - 1) / effective.chunk_bytes;
+    const size_t workers = detail::workerCount(options.threads, chunks);
+
+    FileJob job(text, callback, effective, chunks);
+    detail::spread(workers, [&job](size_t) { job.work(); }, [&job] { job.fail(); });
+    return job.parsed();
+}
+
+}
@@ -0,0 +1,257 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "flat.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "builder.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+/**
+ * @brief Constructs an empty flat expression, with names of its own.
+ */
+FlatExpression::FlatExpression()
+    : FlatExpression(std::make_shared<SymbolTable>())
+{
+}
+
+/**
+ * @brief Constructs an empty flat expression, whose names are interned in `names`.
+ * @param names The table to intern names in, which may be shared with other flat expressions.
+ */
+FlatExpression::FlatExpression(std::shared_ptr<SymbolTable> names)
+    : m_Names(std::move(names))
+{
+}
+
+/**
+ * @brief Gives the number of formulas parsed into this flat expression.
+ */
+size_t FlatExpression::size() const
+{
+    return m_Roots.size();
+}
+
+/**
+ * @brief Gives the root node of a formula.
+ * @param formula The position of the formula, in the order it was parsed in.
+ * @throws std::out_of_range if there is no such formula.
+ */
+auto FlatExpression::root(size_t formula) const -> Index
+{
+    return m_Roots.at(formula);
+}
+
+/**
+ * @brief Builds the `QMLExpression::Expression` tree of a formula.
+ * @param formula The position of the formula, in the order it was parsed in.
+ * @return The same tree `parse()` gives for the formula.
+ * @throws std::out_of_range if there is no such formula.
+ */
+QMLExpression::Expression FlatExpression::expression(size_t formula) const
+{
+    // The nodes of a formula are the ones after the root of the formula before it.
+    const Index last = root(formula);
+    const Index begin = formula == 0 ? 0 : m_Roots[formula - 1] + 1;
+
+    const ExpressionBuilder builder;
+    const auto term = [&](Index index) {
+        return QMLExpression::Term(std::string(m_Names->name(m_TermNames[index])), m_TermTypes[index]);
+    };
+
+    std::vector<QMLExpression::Expression> built;
+    built.reserve(last + 1 - begin);
+    const auto at = [&](Index index) -> const QMLExpression::Expression& { return built[index - begin]; };
+
+    for (Index i = begin; i <= last; ++i) {
+        switch (m_Kinds[i]) {
+        case Kind::UNARY:
+            built.push_back(builder.unary(static_cast<QMLExpression::Operator>(m_Tags[i]), at(m_First[i])));
+            break;
+        case Kind::BINARY:
+            built.push_back(builder.binary(static_cast<QMLExpression::Operator>(m_Tags[i]), at(m_First[i]), at(m_Second[i])));
+            break;
+        case Kind::QUANTIFICATION:
+            built.push_back(builder.quantification(static_cast<QMLExpression::Quantifier>(m_Tags[i]), term(m_First[i]), at(m_Second[i])));
+            break;
+        case Kind::IDENTITY:
+            built.push_back(builder.identity(term(m_First[i]), term(m_Second[i])));
+            break;
+        case Kind::PREDICATION: {
+            const Index count = m_Arguments[m_Second[i]];
+            ExpressionBuilder::Arguments arguments;
+            arguments.reserve(count);
+            for (Index k = 1; k <= count; ++k) {
+                arguments.push_back(term(m_Arguments[m_Second[i] + k]));
+            }
+            built.push_back(builder.predication(m_Names->name(m_First[i]), std::move(arguments)));
+            break;
+        }
+        }
+    }
+
+    return std::move(built.back());
+}
+
+/**
+ * @brief Forgets every formula parsed into this flat expression.
+ *
+ * The names stay in the symbol table, which may be shared.
+ */
+void FlatExpression::clear()
+{
+    m_Kinds.clear();
+    m_Tags.clear();
+    m_First.clear();
+    m_Second.clear();
+    m_Arguments.clear();
+    m_Roots.clear();
+    m_TermNames.clear();
+    m_TermTypes.clear();
+    m_Terms.clear();
+}
+
+auto FlatExpression::kinds() const -> std::span<const Kind>
+{
+    return m_Kinds;
+}
+
+auto FlatExpression::tags() const -> std::span<const uint8_t>
+{
+    return m_Tags;
+}
+
+auto FlatExpression::first() const -> std::span<const Index>
+{
+    return m_First;
+}
+
+auto FlatExpression::second() const -> std::span<const Index>
+{
+    return m_Second;
+}
+
+auto FlatExpression::arguments() const -> std::span<const Index>
+{
+    return m_Arguments;
+}
+
+auto FlatExpression::termNames() const -> std::span<const SymbolTable::Symbol>
+{
+    return m_TermNames;
+}
+
+auto FlatExpression::termTypes() const -> std::span<const QMLExpression::Term::Type>
+{
+    return m_TermTypes;
+}
+
+const SymbolTable& FlatExpression::names() const
+{
+    return *m_Names;
+}
+
+auto FlatExpression::node(Kind kind, uint8_t tag, Index first, Index second) -> Index
+{
+    if (m_Kinds.size() >= std::numeric_limits<Index>::max()) {
+        throw std::length_error("Too many nodes for a FlatExpression");
+    }
+    m_Kinds.push_back(kind);
+    m_Tags.push_back(tag);
+    m_First.push_back(first);
+    m_Second.push_back(second);
+    return static_cast<Index>(m_Kinds.size() - 1);
+}
+
+/**
+ * @brief Constructs a builder that appends a formula to `into`.
+ * @param into The flat expression to build into.
+ */
+FlatBuilder::FlatBuilder(FlatExpression& into)
+    : m_Flat(&into), m_Nodes(into.m_Kinds.size()), m_Arguments(into.m_Arguments.size())
+{
+}
+
+auto FlatBuilder::term(std::string_view literal, TokenType type) const -> TermValue
+{
+    const SymbolTable::Symbol name = m_Flat->m_Names->intern(literal);
+    const QMLExpression::Term::Type termType = type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
+
+    const uint64_t key = (static_cast<uint64_t>(name) << 1) | (termType == QMLExpression::Term::Type::VARIABLE ? 0 : 1);
+    const auto [it, inserted] = m_Flat->m_Terms.try_emplace(key, static_cast<FlatExpression::Index>(m_Flat->m_TermNames.size()));
+    if (inserted) {
+        m_Flat->m_TermNames.push_back(name);
+        m_Flat->m_TermTypes.push_back(termType);
+    }
+    return it->second;
+}
+
+// An argument list starts with the number of its arguments, counted as they come.
+auto FlatBuilder::arguments(size_t) const -> Arguments
+{
+    m_Flat->m_Arguments.push_back(0);
+    return { static_cast<FlatExpression::Index>(m_Flat->m_Arguments.size() - 1) };
+}
+
+void FlatBuilder::argument(Arguments& arguments, TermValue term) const
+{
+    m_Flat->m_Arguments.push_back(term);
+    ++m_Flat->m_Arguments[arguments.begin];
+}
+
+auto FlatBuilder::unary(QMLExpression::Operator op, Value scope) const -> Value
+{
+    return m_Flat->node(FlatExpression::Kind::UNARY, static_cast<uint8_t>(op), scope, 0);
+}
+
+auto FlatBuilder::binary(QMLExpression::Operator op, Value lhs, Value rhs) const -> Value
+{
+    return m_Flat->node(FlatExpression::Kind::BINARY, static_cast<uint8_t>(op), lhs, rhs);
+}
+
+auto FlatBuilder::quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const -> Value
+{
+    return m_Flat->node(FlatExpression::Kind::QUANTIFICATION, static_cast<uint8_t>(quantifier), variable, scope);
+}
+
+auto FlatBuilder::identity(TermValue lhs, TermValue rhs) const -> Value
+{
+    return m_Flat->node(FlatExpression::Kind::IDENTITY, 0, lhs, rhs);
+}
+
+auto FlatBuilder::predication(std::string_view predicate, Arguments arguments) const -> Value
+{
+    return m_Flat->node(FlatExpression::Kind::PREDICATION, 0, m_Flat->m_Names->intern(predicate), arguments.begin);
+}
+
+/**
+ * @brief Records `root` as the root of the formula just parsed.
+ */
+void FlatBuilder::commit(Value root) const
+{
+    m_Flat->m_Roots.push_back(root);
+}
+
+/**
+ * @brief Drops the nodes of a formula that failed to parse.
+ *
+ * Its terms and names stay numbered, so that the numbers of the other terms do not change.
+ */
+void FlatBuilder::discard() const
+{
+    m_Flat->m_Kinds.resize(m_Nodes);
+    m_Flat->m_Tags.resize(m_Nodes);
+    m_Flat->m_First.resize(m_Nodes);
+    m_Flat->m_Second.resize(m_Nodes);
+    m_Flat->m_Arguments.resize(m_Arguments);
+}
+
+}
@@ -0,0 +1,315 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "builder.hpp"
+#include "lexer.hpp"
+#include "teardown.hpp"
+#include "token.hpp"
+#include "workers.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    using Result = std::expected<QMLExpression::Expression, std::string>;
+    using OwnedResult = std::expected<OwnedExpression, std::string>;
+
+    /*
+     * The tokens of one formula, the connectives found outside brackets, and the operands
+     * between them. Operand k runs from just after connective k - 1 to just before
+     * connective k.
+     */
+    class SplitJob
+    {
+    public:
+        SplitJob(const TokenBuffer& tokens, const ParallelOptions& options, size_t workers)
+            : m_Tokens(tokens), m_Options(options), m_Workers(workers), m_Level(detail::connectiveLevel(options.entry))
+        {
+        }
+
+        // The operands left when the job gives up may be deep, and are torn down like the result.
+        ~SplitJob()
+        {
+            for (QMLExpression::Expression& operand : m_Operands) {
+                dismantle(std::move(operand));
+            }
+        }
+
+        /*
+         * Finds the connectives outside brackets. Each worker first measures how its share
+         * of the tokens changes the bracket depth; the depth each share starts at follows,
+         * and each worker then collects the connectives of its share found at depth 0.
+         * Returns false if the formula cannot be split: brackets close that never opened,
+         * a connective the entry rule does not parse, or an empty operand.
+         */
+        bool scan()
+        {
+            // EOI is no operand token.
+            const size_t count = m_Tokens.size() - 1;
+            std::vector<Share> shares(m_Workers);
+            for (size_t i = 0; i < m_Workers; ++i) {
+                shares[i].begin = count * i / m_Workers;
+                shares[i].end = count * (i + 1) / m_Workers;
+            }
+
+            detail::spread(m_Workers, [&](size_t i) { measure(shares[i]); });
+
+            std::ptrdiff_t depth = 0;
+            for (Share& share : shares) {
+                if (depth + share.lowest < 0) {
+                    return false;
+                }
+                share.start = depth;
+                depth += share.change;
+            }
+
+            std::atomic<bool> foreign = false;
+            detail::spread(m_Workers, [&](size_t i) {
+                if (!collect(shares[i])) {
+                    foreign.store(true, std::memory_order_relaxed);
+                }
+            });
+            if (foreign.load(std::memory_order_relaxed)) {
+                return false;
+            }
+
+            for (const Share& share : shares) {
+                m_Connectives.insert(m_Connectives.end(), share.connectives.begin(), share.connectives.end());
+            }
+
+            for (size_t k = 0; k <= m_Connectives.size(); ++k) {
+                if (operandBegin(k) >= operandEnd(k)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        size_t connectives() const
+        {
+            return m_Connectives.size();
+        }
+
+        /*
+         * Parses the operands, each from the entry rule. Since no connective the entry rule
+         * parses is left in an operand outside its brackets, each parses to the clause the
+         * sequential parser finds there. Workers claim runs of operands of about
+         * `chunk_tokens` tokens. Returns false as soon as one of them fails.
+         */
+        bool parseOperands()
+        {
+            std::vector<size_t> runs{ 0 };
+            size_t tokens = 0;
+            for (size_t k = 0; k <= m_Connectives.size(); ++k) {
+                tokens += operandEnd(k) - operandBegin(k);
+                if (tokens >= m_Options.chunk_tokens || k == m_Connectives.size()) {
+                    runs.push_back(k + 1);
+                    tokens = 0;
+                }
+            }
+
+            m_Operands.resize(m_Connectives.size() + 1);
+            std::atomic<size_t> next = 0;
+            const auto fail = [&] { m_Failed.store(true, std::memory_order_relaxed); };
+            detail::spread(std::min(m_Workers, runs.size() - 1), [&](size_t) {
+                TokenBuffer operand;
+                Parser parser(std::as_const(operand), m_Options.mappingFunction);
+                parser.setNestingLimit(m_Options.nesting_limit);
+                const Parser::ParseFunction entryPoint = Parser::entryPointFor(m_Options.entry);
+
+                while (!m_Failed.load(std::memory_order_relaxed)) {
+                    const size_t run = next.fetch_add(1, std::memory_order_relaxed);
+                    if (run + 1 >= runs.size()) {
+                        break;
+                    }
+                    for (size_t k = runs[run]; k < runs[run + 1]; ++k) {
+                        operand.clear();
+                        operand.append(m_Tokens, operandBegin(k), operandEnd(k));
+                        operand.push("EOI", TokenType::EOI);
+
+                        Result result = parser.parse(entryPoint);
+                        if (!result.has_value()) {
+                            fail();
+                            break;
+                        }
+                        m_Operands[k] = std::move(result).value();
+                    }
+                }
+            }, fail);
+            return !m_Failed.load(std::memory_order_relaxed);
+        }
+
+        /*
+         * Combines the operands as the connective rules do: each run of ∧ and ∨ folds left
+         * into an operand of →, each run of → into an operand of ↔, and the ↔ left again.
+         * Returns nothing if the mapping lacks one of the connectives; what was combined by
+         * then goes, with the operands left, when the job does.
+         */
+        std::optional<OwnedExpression> combine()
+        {
+            const auto op = [&](TokenType type) { return m_Options.mappingFunction(type); };
+            const auto ifOp = op(TokenType::IF);
+            const auto eqOp = op(TokenType::EQ);
+            if ((m_Level >= 1 && !ifOp.has_value()) || (m_Level >= 2 && !eqOp.has_value())) {
+                return std::nullopt;
+            }
+
+            const ExpressionBuilder builder;
+            std::optional<QMLExpression::Expression> equivalence;
+            std::optional<QMLExpression::Expression> implication;
+            QMLExpression::Expression junction = std::move(m_Operands[0]);
+
+            const auto close = [&](std::optional<QMLExpression::Expression>& into, QMLExpression::Expression operand, QMLExpression::Operator op) {
+                into = into.has_value() ? builder.binary(op, std::move(*into), std::move(operand)) : std::move(operand);
+            };
+            const auto abandon = [&](QMLExpression::Expression operand) {
+                dismantle(std::move(operand));
+                dismantle(std::move(junction));
+                for (std::optional<QMLExpression::Expression>* partial : { &implication, &equivalence }) {
+                    if (partial->has_value()) {
+                        dismantle(std::move(**partial));
+                    }
+                }
+            };
+
+            for (size_t k = 0; k < m_Connectives.size(); ++k) {
+                QMLExpression::Expression operand = std::move(m_Operands[k + 1]);
+                const TokenType connective = m_Tokens.type(m_Connectives[k]);
+                if (detail::connectiveLevel(connective) == 0) {
+                    const auto junctor = op(connective);
+                    if (!junctor.has_value()) {
+                        abandon(std::move(operand));
+                        return std::nullopt;
+                    }
+                    junction = builder.binary(*junctor, std::move(junction), std::move(operand));
+                    continue;
+                }
+                close(implication, std::move(junction), *ifOp);
+                if (connective == TokenType::EQ) {
+                    close(equivalence, std::move(*implication), *eqOp);
+                    implication.reset();
+                }
+                junction = std::move(operand);
+            }
+
+            close(implication, std::move(junction), ifOp.value_or(QMLExpression::Operator{}));
+            close(equivalence, std::move(*implication), eqOp.value_or(QMLExpression::Operator{}));
+            return OwnedExpression(std::move(*equivalence));
+        }
+
+    private:
+        // A worker's share of the tokens, and the connectives it finds outside brackets.
+        struct Share {
+            size_t begin = 0;
+            size_t end = 0;
+            // The depth at the end of the share, and the lowest one within it, relative to `start`.
+            std::ptrdiff_t change = 0;
+            std::ptrdiff_t lowest = 0;
+            std::ptrdiff_t start = 0;
+            std::vector<size_t> connectives;
+        };
+
+        static std::ptrdiff_t step(TokenType type)
+        {
+            switch (type) {
+            case TokenType::LPAREN:
+            case TokenType::LBRACKET: return 1;
+            case TokenType::RPAREN:
+            case TokenType::RBRACKET: return -1;
+            default: return 0;
+            }
+        }
+
+        void measure(Share& share) const
+        {
+            for (size_t i = share.begin; i < share.end; ++i) {
+                share.change += step(m_Tokens.type(i));
+                share.lowest = std::min(share.lowest, share.change);
+            }
+        }
+
+        // Returns false if a connective outside brackets is one the entry rule does not parse.
+        bool collect(Share& share) const
+        {
+            std::ptrdiff_t depth = share.start;
+            for (size_t i = share.begin; i < share.end; ++i) {
+                const TokenType type = m_Tokens.type(i);
+                depth += step(type);
+                if (depth != 0) {
+                    continue;
+                }
+                const int level = detail::connectiveLevel(type);
+                if (level > m_Level) {
+                    return false;
+                }
+                if (level >= 0) {
+                    share.connectives.push_back(i);
+                }
+            }
+            return true;
+        }
+
+        size_t operandBegin(size_t k) const
+        {
+            return k == 0 ? 0 : m_Connectives[k - 1] + 1;
+        }
+
+        size_t operandEnd(size_t k) const
+        {
+            return k == m_Connectives.size() ? m_Tokens.size() - 1 : m_Connectives[k];
+        }
+
+        const TokenBuffer& m_Tokens;
+        const ParallelOptions& m_Options;
+        size_t m_Workers;
+        int m_Level;
+        std::vector<size_t> m_Connectives;
+        std::vector<QMLExpression::Expression> m_Operands;
+        std::atomic<bool> m_Failed = false;
+    };
+
+    OwnedResult parseWhole(const TokenBuffer& tokens, const ParallelOptions& options)
+    {
+        Parser parser(tokens, options.mappingFunction);
+        parser.setNestingLimit(options.nesting_limit);
+        return parser.parse(Parser::entryPointFor(options.entry));
+    }
+}
+
+std::expected<OwnedExpression, std::string> parse_parallel(std::string_view formula, const ParallelOptions& options)
+{
+    TokenBuffer tokens;
+    tokens.reserve(formula.size() / 2 + 1, 0);
+    lex(formula, tokens);
+
+    const size_t workers = detail::workerCount(options.threads, tokens.size());
+    if (workers < 2 || tokens.size() < options.min_tokens || detail::connectiveLevel(options.entry) < 0) {
+        return parseWhole(tokens, options);
+    }
+
+    ParallelOptions effective = options;
+    effective.chunk_tokens = std::max<size_t>(options.chunk_tokens, 1);
+    SplitJob job(tokens, effective, workers);
+    if (!job.scan() || job.connectives() == 0 || !job.parseOperands()) {
+        return parseWhole(tokens, options);
+    }
+
+    std::optional<OwnedExpression> expression = job.combine();
+    if (!expression.has_value()) {
+        return parseWhole(tokens, options);
+    }
+    return std::move(*expression);
+}
+
+}
@@ -6,442 +6,298 @@
 
 #include "parser.hpp"
 
-#include <format>
+#include <cassert>
+#include <utility>
+
+#include "scratch.hpp"
 
 namespace iif_sadaf::talk::QMLParser {
 
-namespace {
-    bool isTerm(TokenType type)
-    {
-        return type == TokenType::VARIABLE || type == TokenType::IDENTIFIER;
-    }
+template class BasicParser<std::function<std::optional<QMLExpression::Operator>(TokenType)>, Rule::DYNAMIC>;
 
-    bool isUnaryOperator(TokenType type)
-    {
-        return type == TokenType::NOT || type == TokenType::NEC || type == TokenType::POS;
-    }
-
-    bool isQuantifier(TokenType type)
+namespace {
+    using Validator = BasicParser<Parser::MappingFunction, Rule::DYNAMIC, Rejection, NullBuilder>;
+    using Recognizer = BasicParser<AlethicMapping, Rule::DYNAMIC, Rejection, NullBuilder>;
+    using SharingParser = BasicParser<Parser::MappingFunction, Rule::DYNAMIC, std::string, SharingBuilder>;
+    using FlatParser = BasicParser<Parser::MappingFunction, Rule::DYNAMIC, std::string, FlatBuilder>;
+    using SpanningParser = BasicParser<Parser::MappingFunction, Rule::DYNAMIC, std::string, SpanBuilder<ExpressionBuilder>>;
+    using SpanningFlatParser = BasicParser<Parser::MappingFunction, Rule::DYNAMIC, std::string, SpanBuilder<FlatBuilder>>;
+
+    TokenBuffer lexCompact(std::string_view formula)
     {
-        return type == TokenType::FORALL || type == TokenType::EXISTS || type == TokenType::NOT_EXISTS;
+        TokenBuffer tokens;
+        tokens.reserve(formula.size() / 2 + 1, 0);
+        lex(formula, tokens);
+        return tokens;
     }
 }
 
-/**
- * @brief Constructs a Parser instance.
- * @param tokens The list of tokens to parse.
- * @param mapFunc Function that maps tokens to modal operators (default: alethic logic).
- */
-Parser::Parser(const std::vector<Token>& tokens, MappingFunction mapFunc)
-    : m_Index(0), m_LookAhead(TokenType::NIL), m_TokenList(tokens), m_MapToOperator(mapFunc)
+ParserBase::ParserBase()
+    : m_Index(0), m_LookAhead(TokenType::EOI)
 {
-    m_LookAhead = m_TokenList.empty() ? TokenType::EOI : m_TokenList.at(0).type;
 }
 
-/**
- * @brief Parses the token stream into a QML expression.
- * @param entryPoint The starting parse rule (default: equivalence).
- * @return Parsed QML expression or an error message.
- */
-std::expected<QMLExpression::Expression, std::string> Parser::parse(ParseFunction entryPoint)
+ParserBase::ParserBase(const std::vector<Token>& tokens)
+    : m_Index(0), m_LookAhead(TokenType::NIL), m_OwnedTokens(tokens)
 {
-    m_Index = 0;
-    m_LookAhead = m_TokenList.empty() ? TokenType::EOI : m_TokenList.at(0).type;
-
-    m_EntryPoint = entryPoint;
-
-    if (m_TokenList.empty()) {
-        return std::unexpected("Empty input string, nothing to do");
-    }
-
-    return sentence();
+    start();
+    detail::count(&ParseStats::copied_tokens, tokens.size());
 }
 
-
-void Parser::advance()
+ParserBase::ParserBase(std::span<const Token> tokens)
+    : m_Index(0), m_LookAhead(TokenType::NIL), m_OwnedTokens(tokens)
 {
-    if (m_LookAhead != TokenType::EOI) {
-        m_Index++;
-        m_LookAhead = m_TokenList.at(m_Index).type;
-    }
+    start();
+    detail::count(&ParseStats::copied_tokens, tokens.size());
 }
 
-TokenType Parser::peek(int offset) const
+ParserBase::ParserBase(const std::vector<TokenView>& tokens)
+    : m_Index(0), m_LookAhead(TokenType::NIL), m_OwnedTokens(tokens)
 {
-    if (m_Index + offset < m_TokenList.size()) {
-        return m_TokenList.at(m_Index + offset).type;
-    }
-    return TokenType::EOI;
+    start();
+    detail::count(&ParseStats::copied_tokens, tokens.size());
 }
 
-const Token& Parser::getToken(size_t index) const {
-    if (index < m_TokenList.size()) {
-        return m_TokenList.at(index);
-    }
-    return m_TokenList.at(m_TokenList.size() - 1);
+ParserBase::ParserBase(const TokenBuffer& tokens)
+    : m_Index(0), m_LookAhead(TokenType::NIL), m_Tokens(&tokens)
+{
+    start();
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::sentence()
+ParserBase::ParserBase(TokenBuffer&& tokens)
+    : m_Index(0), m_LookAhead(TokenType::NIL), m_OwnedTokens(std::move(tokens))
 {
-    const auto result = m_EntryPoint(*this);
-
-    if (!result.has_value()) {
-        return std::unexpected(result.error());
-    }
-    
-    if (peek() != TokenType::EOI) {
-        return std::unexpected(std::format("Unexpected symbol ({})", getToken(m_Index).literal));
-    }
-
-    return result.value();
+    start();
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::equivalence()
+ParserBase::ParserBase(Lexer& lexer)
+    : m_Index(0), m_LookAhead(TokenType::NIL), m_Lexer(&lexer)
 {
-    const auto result = implication();
-    if (!result.has_value()) {
-        return std::unexpected(result.error());
-    }
-
-    QMLExpression::Expression lhs = result.value();
-
-    while (peek() == TokenType::EQ) {
-        advance(); // consume equivalence
-        const auto result = implication();
-        if (!result.has_value()) {
-            return std::unexpected(std::format("Expected clause after '↔' but got : {}", result.error()));
-        }
-        QMLExpression::Expression rhs = result.value();
-        if (const auto op = m_MapToOperator(TokenType::EQ)) {
-            lhs = std::make_shared<QMLExpression::BinaryNode>(*op, lhs, rhs);
-        }
-        else {
-            return std::unexpected("Non-existent map for token type EQ (↔)");
-        }
-    }
-
-    return lhs;
+    m_LookAhead = m_Lexer->peek().type;
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::implication()
+// A parser reading its own buffer must read the copy, not the source's. One reading from
+// a lexer cannot be copied, as both would advance it.
+ParserBase::ParserBase(const ParserBase& other)
+    : m_Index(other.m_Index),
+      m_LookAhead(other.m_LookAhead),
+      m_NestingLimit(other.m_NestingLimit),
+      m_OwnedTokens(other.m_OwnedTokens),
+      m_Tokens(other.m_Tokens == &other.m_OwnedTokens ? &m_OwnedTokens : other.m_Tokens)
 {
-    const auto result = conjunction_disjunction();
-    if (!result.has_value()) {
-        return std::unexpected(result.error());
-    }
-    
-    QMLExpression::Expression lhs = result.value();
-
-    while (peek() == TokenType::IF) {
-        advance(); // consume implication
-        const auto result = conjunction_disjunction();
-        if (!result.has_value()) {
-            return std::unexpected(std::format("Expected clause after '→' but got : {}", result.error()));
-        }
-        QMLExpression::Expression rhs = result.value();
-        if (const auto op = m_MapToOperator(TokenType::IF)) {
-            lhs = std::make_shared<QMLExpression::BinaryNode>(*op, lhs, rhs);
-        }
-        else {
-            return std::unexpected("Non-existent map for token type IMP (→)");
-        }
-    }
-
-    return lhs;
+    assert(other.m_Lexer == nullptr && "a parser reading from a Lexer cannot be copied");
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::conjunction_disjunction()
+ParserBase& ParserBase::operator=(const ParserBase& other)
 {
-    const auto result = clause();
-    if (!result.has_value()) {
-        return std::unexpected(result.error());
-    }
-    
-    QMLExpression::Expression lhs = result.value();
-
-    while (peek() == TokenType::OR || peek() == TokenType::AND) {
-        // Identify operator
-        const auto currentToken = getToken(m_Index);
-        const auto op = currentToken.type == TokenType::OR ? m_MapToOperator(TokenType::OR) : m_MapToOperator(TokenType::AND);
-        const std::string opName = currentToken.type == TokenType::OR ? "OR (∨)" : "AND (∧)";
-
-        if (!op.has_value()) {
-            return std::unexpected(std::format("Non-existent map for token type {}", opName));
-        }
-
-        advance(); // consume operator
-        const auto result = clause();
-        if (!result.has_value()) {
-            return std::unexpected(std::format("Expected clause after '{}' but got : {}", currentToken.literal, result.error()));
-        }
-        QMLExpression::Expression rhs = result.value();
-        lhs = std::make_shared<QMLExpression::BinaryNode>(*op, lhs, rhs);
-    }
-
-    return lhs;
+    assert(other.m_Lexer == nullptr && "a parser reading from a Lexer cannot be copied");
+    if (this != &other) {
+        m_Index = other.m_Index;
+        m_LookAhead = other.m_LookAhead;
+        m_NestingLimit = other.m_NestingLimit;
+        m_OwnedTokens = other.m_OwnedTokens;
+        m_Tokens = other.m_Tokens == &other.m_OwnedTokens ? &m_OwnedTokens : other.m_Tokens;
+        m_Lexer = nullptr;
+    }
+    return *this;
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::clause()
+// Likewise, a parser reading its own buffer must read the moved one, and a lexer is
+// handed over, so that only one parser is left advancing it.
+ParserBase::ParserBase(ParserBase&& other) noexcept
+    : m_Index(other.m_Index),
+      m_LookAhead(other.m_LookAhead),
+      m_NestingLimit(other.m_NestingLimit),
+      m_OwnedTokens(std::move(other.m_OwnedTokens)),
+      m_Tokens(other.m_Tokens == &other.m_OwnedTokens ? &m_OwnedTokens : other.m_Tokens),
+      m_Lexer(std::exchange(other.m_Lexer, nullptr))
 {
-    const auto currentToken = getToken(m_Index);
-    
-    if (isTerm(currentToken.type)) {
-        return atomic();
-    }
-
-    if (isUnaryOperator(currentToken.type)) {
-        return unary();
-    }
-
-    if (isQuantifier(currentToken.type)) {
-        return quantificational();
-    }
-
-    if (currentToken.type == TokenType::LPAREN) {
-        advance();
-        const auto result = m_EntryPoint(*this);
-        if (!result.has_value()) {
-            return std::unexpected(result.error());
-        }
-        if (peek() != TokenType::RPAREN) {
-            return std::unexpected(std::format("Expected ')' after '{}' but got '{}'", currentToken.literal, getToken(m_Index).literal));
-        }
-        advance();
-        return result.value();
-    }
-
-    if (currentToken.type == TokenType::LBRACKET) {
-        advance();
-        const auto result = m_EntryPoint(*this);
-        if (!result.has_value()) {
-            return std::unexpected(result.error());
-        }
-        if (peek() != TokenType::RBRACKET) {
-            return std::unexpected(std::format("Expected ']' after '{}' but got '{}'", currentToken.literal, getToken(m_Index).literal));
-        }
-        advance();
-        return result.value();
-    }
-
-    return std::unexpected(std::format("Unexpected token ({})", currentToken.literal));
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::quantificational()
+ParserBase& ParserBase::operator=(ParserBase&& other) noexcept
 {
-    if (!isQuantifier(peek())) {
-        return std::unexpected("");
-    }
-
-    if (peek(1) != TokenType::VARIABLE) {
-        return std::unexpected(std::format("Expected variable after '{}' but got '{}'", getToken(m_Index).literal, getToken(m_Index + 1).literal));
-    }
-
-    QMLExpression::Quantifier quantifier = getToken(m_Index).type == TokenType::FORALL ? QMLExpression::Quantifier::UNIVERSAL : QMLExpression::Quantifier::EXISTENTIAL;
-    const bool negated = getToken(m_Index).type == TokenType::NOT_EXISTS;
-
-    advance(); // consume quantifier
-
-    QMLExpression::Term variable(getToken(m_Index).literal, QMLExpression::Term::Type::VARIABLE);
-
-    advance(); // consume variable
-
-    const auto result = clause();
-
-    if (!result.has_value()) {
-        return std::unexpected(result.error());
-    }
-
-    QMLExpression::Expression quantified = std::make_shared<QMLExpression::QuantificationNode>(quantifier, variable, result.value());
-
-    if (negated) {
-        if (const auto op = m_MapToOperator(TokenType::NOT)) {
-            return std::make_shared<QMLExpression::UnaryNode>(*op, quantified);
-        }
-        return std::unexpected("Non-existent map for token type NOT (¬)");
-    }
-
-    return quantified;
+    if (this != &other) {
+        m_Index = other.m_Index;
+        m_LookAhead = other.m_LookAhead;
+        m_NestingLimit = other.m_NestingLimit;
+        m_OwnedTokens = std::move(other.m_OwnedTokens);
+        m_Tokens = other.m_Tokens == &other.m_OwnedTokens ? &m_OwnedTokens : other.m_Tokens;
+        m_Lexer = std::exchange(other.m_Lexer, nullptr);
+    }
+    return *this;
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::unary()
+/**
+ * @brief Replaces the tokens to parse with those of `formula`.
+ *
+ * The formula is lexed as by `lex()` into buffers the parser keeps from one call to the
+ * next, so once they have grown to fit, a reset allocates nothing. The parser owns the
+ * tokens, and `formula` need not outlive the call. The mapping function and the memory
+ * resource are kept.
+ *
+ * @param formula The input string representing a QML formula.
+ */
+void ParserBase::reset(std::string_view formula)
 {
-    if (!isUnaryOperator(peek())) {
-        return std::unexpected("");
-    }
-
-    const auto currentToken = getToken(m_Index);
-    const auto op = currentToken.type == TokenType::NOT ? m_MapToOperator(TokenType::NOT) :
-                    currentToken.type == TokenType::POS ? m_MapToOperator(TokenType::POS) :
-                                                          m_MapToOperator(TokenType::NEC);
-    const std::string opName = currentToken.type == TokenType::NOT ? "NOT (¬)" :
-                               currentToken.type == TokenType::POS ? "POS (⋄)" :
-                                                                     "NEC (□)";
-
-    if (!op.has_value()) {
-        return std::unexpected(std::format("Non-existent map for unary operator {}", opName));
-    }
-
-    advance(); // consume operator
-
-    const auto result = clause();
-    if (!result.has_value()) {
-        return std::unexpected(std::format("Expected clause after unary operator {}", opName));
-    }
-
-    return std::make_shared<QMLExpression::UnaryNode>(*op, result.value());
+    m_Lexer = nullptr;
+    lex(formula, m_OwnedTokens);
+    m_Tokens = &m_OwnedTokens;
+    start();
+    m_Index = 0;
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::atomic()
+/**
+ * @brief Sets how deeply formulas may nest.
+ *
+ * Every prefix operator, quantifier and bracket enclosing a subformula counts as a level.
+ * The parser keeps a frame on the heap for each open level instead of a native call, so
+ * the limit bounds its memory use, not the stack; a formula that goes past it fails with
+ * `ErrorCode::NESTING_TOO_DEEP`. Whatever the parser gives up on is torn down with
+ * `dismantle()`, but destroying a tree it returns takes a native call per level, so above
+ * the default, results should be let go of through `dismantle()` too.
+ *
+ * @param limit The number of levels allowed (default: `default_nesting_limit`).
+ */
+void ParserBase::setNestingLimit(size_t limit)
 {
-    if (peek() != TokenType::IDENTIFIER && peek() != TokenType::VARIABLE) {
-        return std::unexpected("");
-    }
-
-    if (peek(1) == TokenType::LPAREN) {
-        return predication();
-    }
-    
-    if (peek(1) == TokenType::ID) {
-        return identity();
-    }
-    
-    if (peek(1) == TokenType::NEQ) {
-        return inequality();
-    }
-    
-    return std::unexpected(std::format("Expected '(', '=', or '≠' after '{}' but got '{}'", getToken(m_Index).literal, getToken(m_Index + 1).literal));
+    m_NestingLimit = limit;
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::predication()
+// Looks at the first token of the buffer read from.
+void ParserBase::start()
 {
-    if (peek() != TokenType::IDENTIFIER) {
-        return std::unexpected("");
-    }
-
-    if (peek(1) != TokenType::LPAREN) {
-        return std::unexpected("");
-    }
-
-    if (!isTerm(peek(2))) {
-        return std::unexpected(std::format("Expected term after '(' but got '{}'", getToken(m_Index + 2).literal));
-    }
-
-    if (peek(3) != TokenType::RPAREN && peek(3) != TokenType::COMMA) {
-        return std::unexpected(std::format("Expected ',' or ')' after term '{}' but got '{}'", getToken(m_Index + 2).literal, getToken(m_Index + 3).literal));
-    }
-
-    const int backtracking_point = m_Index;
-
-    std::string predicate = getToken(m_Index).literal;
-    
-    advance(); // consume predicate
-    advance(); // consume LPAREN
-
-    std::vector<QMLExpression::Term> arguments;
-
-    QMLExpression::Term::Type type = getToken(m_Index).type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
-    arguments.push_back({ getToken(m_Index).literal, type });
-
-    advance(); // consume first argument
-
-    while (peek() == TokenType::COMMA) {
-        if (!isTerm(peek(1))) {
-            const std::string error_string = std::format("Expected term after ',' but got '{}'", getToken(m_Index + 1).literal);
-            m_Index = backtracking_point;
-            m_LookAhead = getToken(m_Index).type;
-            return std::unexpected(error_string);
-        }
-
-        advance(); // consume comma
-
-        QMLExpression::Term::Type type = getToken(m_Index).type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
-        arguments.push_back({ getToken(m_Index).literal, type });
-
-        advance(); // consume argument
-    }
-
-    if (peek() != TokenType::RPAREN) {
-        const std::string error_string = std::format("Expected ')' after argument list but got '{}'", getToken(m_Index).literal);
-        m_Index = backtracking_point;
-        m_LookAhead = getToken(m_Index).type;
-        return std::unexpected(error_string);
-    }
-
-    advance(); // consume RPAREN
-
-    return std::make_shared<QMLExpression::PredicationNode>(predicate, arguments);
+    m_LookAhead = m_Tokens->empty() ? TokenType::EOI : m_Tokens->type(0);
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::identity()
+// Moves back to the first token. Returns false if there are no tokens at all.
+bool ParserBase::rewind()
 {
-    if (!isTerm(peek())) {
-        return std::unexpected("");
+    m_Index = 0;
+    if (m_Lexer != nullptr) {
+        m_LookAhead = m_Lexer->peek().type;
+        return true;
     }
+    start();
+    return !m_Tokens->empty();
+}
 
-    if (peek(1) != TokenType::ID) {
-        return std::unexpected("");
-    }
+// Records the current position, so that a rule can give back the tokens it consumed.
+ParserBase::Checkpoint ParserBase::mark() const
+{
+    return { m_Index, m_Lexer != nullptr ? m_Lexer->offset() : 0 };
+}
 
-    if (!isTerm(peek(2))) {
-        return std::unexpected(std::format("Expected singular term in RHS of '=' but got '{}'", getToken(m_Index + 2).literal));
+void ParserBase::restore(Checkpoint checkpoint)
+{
+    m_Index = checkpoint.index;
+    if (m_Lexer != nullptr) {
+        m_Lexer->seek(checkpoint.offset);
     }
+    m_LookAhead = getToken(m_Index).type;
+}
 
-    QMLExpression::Term::Type type = getToken(m_Index).type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
-    QMLExpression::Term lhs(getToken(m_Index).literal, type);
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, Parser::ParseFunction entryPoint, Parser::MappingFunction mapFunction)
+{
+    // Lexing and parsing are counted as one call.
+    const detail::StatsScope scope;
+    return Parser(lexCompact(formula), std::move(mapFunction)).parse(std::move(entryPoint));
+}
 
-    advance(); // consume lhs
-    advance(); // consume ID
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, Parser::MappingFunction mapFunction)
+{
+    const detail::StatsScope scope;
+    return Parser(lexCompact(formula), std::move(mapFunction)).parse();
+}
 
-    type = getToken(m_Index).type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
-    QMLExpression::Term rhs(getToken(m_Index).literal, type);
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, std::pmr::memory_resource& arena, Parser::ParseFunction entryPoint, Parser::MappingFunction mapFunction)
+{
+    const detail::StatsScope scope;
+    Parser parser(lexCompact(formula), std::move(mapFunction));
+    parser.setMemoryResource(&arena);
+    return parser.parse(std::move(entryPoint));
+}
 
-    advance(); // consume rhs
+std::expected<OwnedExpression, std::string> parse_owned(const std::string& formula, Parser::ParseFunction entryPoint, Parser::MappingFunction mapFunction)
+{
+    const detail::StatsScope scope;
+    return Parser(lexCompact(formula), std::move(mapFunction)).parse(std::move(entryPoint));
+}
 
-    return std::make_shared<QMLExpression::IdentityNode>(lhs, rhs);
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, ExpressionPool& pool, Rule entry, Parser::MappingFunction mapFunction)
+{
+    const detail::StatsScope scope;
+    return SharingParser(lexCompact(formula), std::move(mapFunction), SharingBuilder(pool)).parse(SharingParser::entryPointFor(entry));
 }
 
-std::expected<QMLExpression::Expression, std::string> Parser::inequality()
+std::expected<FlatExpression::Index, std::string> parse(const std::string& formula, FlatExpression& into, Rule entry, Parser::MappingFunction mapFunction)
 {
-    if (!isTerm(peek())) {
-        return std::unexpected("");
+    const detail::StatsScope scope;
+    const FlatBuilder builder(into);
+    auto result = FlatParser(lexCompact(formula), std::move(mapFunction), builder).parse(FlatParser::entryPointFor(entry));
+    if (result.has_value()) {
+        builder.commit(result.value());
     }
-
-    if (peek(1) != TokenType::NEQ) {
-        return std::unexpected("");
+    else {
+        builder.discard();
     }
+    return result;
+}
 
-    if (!isTerm(peek(2))) {
-        return std::unexpected(std::format("Expected singular term in RHS of '≠' but got '{}'", getToken(m_Index + 1).literal));
+std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, std::vector<SourceSpan>& spans, Rule entry, Parser::MappingFunction mapFunction)
+{
+    const detail::StatsScope scope;
+    // Borrowed for the call, like the tokens of validate().
+    const detail::Scratch<TokenBuffer> tokens;
+    const detail::Scratch<std::vector<SourceSpan>> tokenSpans;
+    lex(formula, *tokens, *tokenSpans);
+
+    spans.clear();
+    const SpanBuilder<ExpressionBuilder> builder(ExpressionBuilder(), *tokenSpans, spans);
+    auto result = SpanningParser(std::as_const(*tokens), std::move(mapFunction), builder).parse(SpanningParser::entryPointFor(entry));
+    if (!result.has_value()) {
+        spans.clear();
     }
+    return result;
+}
 
-    QMLExpression::Term::Type type = getToken(m_Index).type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
-    QMLExpression::Term lhs(getToken(m_Index).literal, type);
-
-    advance(); // consume lhs
-    advance(); // consume NEQ operator
-
-    type = getToken(m_Index).type == TokenType::VARIABLE ? QMLExpression::Term::Type::VARIABLE : QMLExpression::Term::Type::CONSTANT;
-    QMLExpression::Term rhs(getToken(m_Index).literal, type);
-
-    advance(); // consume rhs
-
-    QMLExpression::Expression id = std::make_shared<QMLExpression::IdentityNode>(lhs, rhs);
-    if (const auto op = m_MapToOperator(TokenType::NOT)) {
-        return std::make_shared<QMLExpression::UnaryNode>(*op, id);
-    }
-    return std::unexpected("Non-existent map for token type NOT (¬)");
+std::expected<FlatExpression::Index, std::string> parse(const std::string& formula, FlatExpression& into, std::vector<SourceSpan>& spans, Rule entry, Parser::MappingFunction mapFunction)
+{
+    const detail::StatsScope scope;
+    const detail::Scratch<TokenBuffer> tokens;
+    const detail::Scratch<std::vector<SourceSpan>> tokenSpans;
+    lex(formula, *tokens, *tokenSpans);
+
+    const size_t before = into.kinds().size();
+    spans.resize(before);
+    const SpanBuilder<FlatBuilder> builder(FlatBuilder(into), *tokenSpans, spans);
+    auto result = SpanningFlatParser(std::as_const(*tokens), std::move(mapFunction), builder).parse(SpanningFlatParser::entryPointFor(entry));
+    if (result.has_value()) {
+        builder.inner().commit(result.value());
+    }
+    else {
+        builder.inner().discard();
+        spans.resize(before);
+    }
+    return result;
 }
 
-std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, Parser::ParseFunction entryPoint, Parser::MappingFunction mapFunction)
+bool validate(std::string_view formula, Rule entry, Parser::MappingFunction mapFunction)
 {
-    const std::vector<Token> tokens = lex(formula);
-    return Parser(tokens, mapFunction).parse(entryPoint);
+    const detail::StatsScope scope;
+    // Borrowed from the thread's scratch buffers (see detail::Scratch), so that validating
+    // formula after formula stops allocating tokens, even if the mapping validates another.
+    const detail::Scratch<TokenBuffer> tokens;
+    lex(formula, *tokens);
+    return Validator(std::as_const(*tokens), std::move(mapFunction)).parse(Validator::entryPointFor(entry)).has_value();
 }
 
-std::expected<QMLExpression::Expression, std::string> parse(const std::string& formula, Parser::MappingFunction mapFunction)
+bool is_well_formed(std::string_view formula, Rule entry)
 {
-    const std::vector<Token> tokens = lex(formula);
-    return Parser(tokens, mapFunction).parse();
+    const detail::StatsScope scope;
+    // Once the scratch buffer has grown, recognizing a formula allocates nothing.
+    const detail::Scratch<TokenBuffer> tokens;
+    lex(formula, *tokens);
+    return Recognizer(std::as_const(*tokens)).parse(Recognizer::entryPointFor(entry)).has_value();
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "pool.hpp"
+
+#include <functional>
+#include <variant>
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    const void* address(const QMLExpression::Expression& expression)
+    {
+        return std::visit([](const auto& node) -> const void* { return node.get(); }, expression);
+    }
+
+    size_t combine(size_t seed, size_t value)
+    {
+        return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    // Appends a term to the names of a key, marked with its type and ended by a separator.
+    void appendTerm(std::string& text, std::string_view literal, TokenType type)
+    {
+        text += type == TokenType::VARIABLE ? 'v' : 'c';
+        text += literal;
+        text += '\0';
+    }
+}
+
+/**
+ * @brief Gives the number of distinct nodes in the pool.
+ * @return The number of nodes built so far and not cleared.
+ */
+size_t ExpressionPool::size() const
+{
+    return m_Nodes.size();
+}
+
+/**
+ * @brief Forgets every node in the pool.
+ *
+ * Expressions already built keep their nodes alive; later ones will no longer share them.
+ */
+void ExpressionPool::clear()
+{
+    m_Nodes.clear();
+}
+
+size_t ExpressionPool::Hash::operator()(const KeyView& key) const
+{
+    size_t hash = std::hash<std::string_view>{}(key.text);
+    hash = combine(hash, static_cast<size_t>(key.kind));
+    hash = combine(hash, static_cast<size_t>(key.tag));
+    hash = combine(hash, std::hash<const void*>{}(key.first));
+    return combine(hash, std::hash<const void*>{}(key.second));
+}
+
+size_t ExpressionPool::Hash::operator()(const Key& key) const
+{
+    return (*this)(view(key));
+}
+
+/**
+ * @brief Constructs a builder that takes its nodes from `pool`.
+ * @param pool The pool to look nodes up in; it must outlive the builder.
+ */
+SharingBuilder::SharingBuilder(ExpressionPool& pool)
+    : m_Pool(&pool)
+{
+}
+
+auto SharingBuilder::arguments(size_t) const -> Arguments
+{
+    // Argument lists hold terms only, so there is never more than one being built.
+    m_Pool->m_Arguments.clear();
+    return {};
+}
+
+void SharingBuilder::argument(Arguments&, TermValue term) const
+{
+    m_Pool->m_Arguments.emplace_back(term.literal, term.type);
+}
+
+auto SharingBuilder::unary(QMLExpression::Operator op, Value scope) const -> Value
+{
+    const ExpressionPool::KeyView key{ ExpressionPool::Kind::UNARY, static_cast<int>(op), address(scope), nullptr, {} };
+    return m_Pool->intern(key, [&] { return m_Pool->m_Builder.unary(op, std::move(scope)); });
+}
+
+auto SharingBuilder::binary(QMLExpression::Operator op, Value lhs, Value rhs) const -> Value
+{
+    const ExpressionPool::KeyView key{ ExpressionPool::Kind::BINARY, static_cast<int>(op), address(lhs), address(rhs), {} };
+    return m_Pool->intern(key, [&] { return m_Pool->m_Builder.binary(op, std::move(lhs), std::move(rhs)); });
+}
+
+auto SharingBuilder::quantification(QMLExpression::Quantifier quantifier, TermValue variable, Value scope) const -> Value
+{
+    const ExpressionPool::KeyView key{ ExpressionPool::Kind::QUANTIFICATION, static_cast<int>(quantifier), address(scope), nullptr, variable.literal };
+    return m_Pool->intern(key, [&] {
+        return m_Pool->m_Builder.quantification(quantifier, m_Pool->m_Builder.term(variable.literal, variable.type), std::move(scope));
+    });
+}
+
+auto SharingBuilder::identity(TermValue lhs, TermValue rhs) const -> Value
+{
+    std::string& text = m_Pool->m_Text;
+    text.clear();
+    appendTerm(text, lhs.literal, lhs.type);
+    appendTerm(text, rhs.literal, rhs.type);
+
+    const ExpressionPool::KeyView key{ ExpressionPool::Kind::IDENTITY, 0, nullptr, nullptr, text };
+    return m_Pool->intern(key, [&] {
+        const ExpressionBuilder& builder = m_Pool->m_Builder;
+        return builder.identity(builder.term(lhs.literal, lhs.type), builder.term(rhs.literal, rhs.type));
+    });
+}
+
+auto SharingBuilder::predication(std::string_view predicate, Arguments) const -> Value
+{
+    std::string& text = m_Pool->m_Text;
+    text.assign(predicate);
+    text += '\0';
+    for (const auto& [literal, type] : m_Pool->m_Arguments) {
+        appendTerm(text, literal, type);
+    }
+
+    const ExpressionPool::KeyView key{ ExpressionPool::Kind::PREDICATION, 0, nullptr, nullptr, text };
+    return m_Pool->intern(key, [&] {
+        const ExpressionBuilder& builder = m_Pool->m_Builder;
+        ExpressionBuilder::Arguments arguments = builder.arguments(m_Pool->m_Arguments.size());
+        for (const auto& [literal, type] : m_Pool->m_Arguments) {
+            builder.argument(arguments, builder.term(literal, type));
+        }
+        return builder.predication(predicate, std::move(arguments));
+    });
+}
+
+}
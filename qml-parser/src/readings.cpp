@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "readings.hpp"
+
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "builder.hpp"
+#include "scratch.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    using QMLExpression::Expression;
+    using QMLExpression::Operator;
+
+    using ReadingParser = BasicParser<AlethicMapping>;
+
+    std::optional<Operator> modalOperator(Modality modality, TokenType type)
+    {
+        switch (modality) {
+        case Modality::DEONTIC: return DeonticMapping{}(type);
+        case Modality::EPISTEMIC: return EpistemicMapping{}(type);
+        default: return AlethicMapping{}(type);
+        }
+    }
+
+    Operator relabelOperator(Operator op, Modality modality)
+    {
+        switch (op) {
+        case Operator::NECESSITY:
+        case Operator::DEONTIC_NECESSITY:
+        case Operator::EPISTEMIC_NECESSITY:
+            return *modalOperator(modality, TokenType::NEC);
+        case Operator::POSSIBILITY:
+        case Operator::DEONTIC_POSSIBILITY:
+        case Operator::EPISTEMIC_POSSIBILITY:
+            return *modalOperator(modality, TokenType::POS);
+        default:
+            return op;
+        }
+    }
+
+    const void* address(const Expression& expression)
+    {
+        return std::visit([](const auto& node) -> const void* { return node.get(); }, expression);
+    }
+
+    // The subformulas of a node, which are relabeled before the node itself.
+    std::pair<const Expression*, const Expression*> children(const Expression& expression)
+    {
+        if (const auto* unary = std::get_if<std::shared_ptr<QMLExpression::UnaryNode>>(&expression)) {
+            return { &(*unary)->scope, nullptr };
+        }
+        if (const auto* binary = std::get_if<std::shared_ptr<QMLExpression::BinaryNode>>(&expression)) {
+            return { &(*binary)->lhs, &(*binary)->rhs };
+        }
+        if (const auto* quantification = std::get_if<std::shared_ptr<QMLExpression::QuantificationNode>>(&expression)) {
+            return { &(*quantification)->scope, nullptr };
+        }
+        return { nullptr, nullptr };
+    }
+}
+
+/**
+ * @brief Constructs the readings of a formula from its alethic reading.
+ * @param alethic The formula as parsed with `mapToAlethicOperator`.
+ */
+ModalReadings::ModalReadings(QMLExpression::Expression alethic)
+{
+    m_Readings[static_cast<size_t>(Modality::ALETHIC)] = std::move(alethic);
+}
+
+/**
+ * @brief Gives the formula as parsed with the mapping of `modality`.
+ * @param modality The modality to read the box and the diamond in.
+ * @return The reading, which stays valid as long as this object.
+ */
+const QMLExpression::Expression& ModalReadings::reading(Modality modality)
+{
+    std::optional<QMLExpression::Expression>& reading = m_Readings[static_cast<size_t>(modality)];
+    if (!reading.has_value()) {
+        reading = relabel(*m_Readings[static_cast<size_t>(Modality::ALETHIC)], modality);
+    }
+    return *reading;
+}
+
+std::expected<ModalReadings, std::string> parse_readings(std::string_view formula, Rule entry)
+{
+    const detail::StatsScope scope;
+
+    // Borrowed for the call, so that the token buffer is reused from one formula to the next.
+    const detail::Scratch<TokenBuffer> tokens;
+    lex(formula, *tokens);
+
+    auto result = ReadingParser(std::as_const(*tokens)).parse(ReadingParser::entryPointFor(entry));
+    if (!result.has_value()) {
+        return std::unexpected(std::move(result).error());
+    }
+    return ModalReadings(std::move(result).value());
+}
+
+QMLExpression::Expression relabel(const QMLExpression::Expression& expression, Modality modality)
+{
+    // A node is visited twice: first to schedule its children, then, once their relabeled
+    // versions are on `done`, to rebuild it if anything changed.
+    struct Visit {
+        const Expression* expression;
+        bool expanded;
+    };
+
+    const ExpressionBuilder builder;
+    std::vector<Visit> pending{ { &expression, false } };
+    std::vector<Expression> done;
+
+    while (!pending.empty()) {
+        const Visit visit = pending.back();
+        pending.pop_back();
+        const auto [first, second] = children(*visit.expression);
+
+        if (!visit.expanded) {
+            pending.push_back({ visit.expression, true });
+            if (second != nullptr) {
+                pending.push_back({ second, false });
+            }
+            if (first != nullptr) {
+                pending.push_back({ first, false });
+            }
+            continue;
+        }
+
+        if (first == nullptr) {
+            done.push_back(*visit.expression);
+            continue;
+        }
+
+        if (second != nullptr) {
+            Expression rhs = std::move(done.back());
+            done.pop_back();
+            Expression lhs = std::move(done.back());
+            done.pop_back();
+
+            const auto& node = std::get<std::shared_ptr<QMLExpression::BinaryNode>>(*visit.expression);
+            if (address(lhs) == address(node->lhs) && address(rhs) == address(node->rhs)) {
+                done.push_back(*visit.expression);
+            }
+            else {
+                done.push_back(builder.binary(node->op, std::move(lhs), std::move(rhs)));
+            }
+            continue;
+        }
+
+        Expression scope = std::move(done.back());
+        done.pop_back();
+
+        if (const auto* unary = std::get_if<std::shared_ptr<QMLExpression::UnaryNode>>(visit.expression)) {
+            const Operator op = relabelOperator((*unary)->op, modality);
+            if (op == (*unary)->op && address(scope) == address((*unary)->scope)) {
+                done.push_back(*visit.expression);
+            }
+            else {
+                done.push_back(builder.unary(op, std::move(scope)));
+            }
+        }
+        else {
+            const auto& node = std::get<std::shared_ptr<QMLExpression::QuantificationNode>>(*visit.expression);
+            if (address(scope) == address(node->scope)) {
+                done.push_back(*visit.expression);
+            }
+            else {
+                done.push_back(builder.quantification(node->quantifier, node->variable, std::move(scope)));
+            }
+        }
+    }
+
+    return std::move(done.back());
+}
+
+}
@@ -0,0 +1,536 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "recovery.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "builder.hpp"
+#include "lexer.hpp"
+#include "scratch.hpp"
+#include "teardown.hpp"
+#include "token.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    using Partial = std::optional<QMLExpression::Expression>;
+
+    /*
+     * Parses the tokens of one formula from left to right without stopping at errors. The
+     * brackets open at the current token are kept as a stack of levels, the first one for
+     * the formula itself, and the prefixes of the operand under way at each level on a stack
+     * shared by all of them. Each level folds its operands as the connective rules do: runs
+     * of ∧ and ∨ into an operand of →, runs of → into an operand of ↔.
+     */
+    class Recovery
+    {
+    public:
+        Recovery(const TokenBuffer& tokens, Rule entry, const Parser::MappingFunction& mapping)
+            : m_Tokens(tokens), m_Mapping(mapping), m_Level(detail::connectiveLevel(entry)),
+              m_IfOp(mapping(TokenType::IF)), m_EqOp(mapping(TokenType::EQ)), m_NotOp(mapping(TokenType::NOT))
+        {
+        }
+
+        RecoveredParse run()
+        {
+            m_Levels.push_back({});
+            size_t i = 0;
+            while (!(m_Levels.back().operand ? operand(i) : after(i))) {
+            }
+            return { .expression = finish(), .diagnostics = std::move(m_Diagnostics) };
+        }
+
+    private:
+        static constexpr size_t none = static_cast<size_t>(-1);
+
+        // A unary operator or a quantifier and its variable, waiting for its scope.
+        struct Prefix {
+            TokenType token = TokenType::NIL;
+            // The operator to apply; for a quantifier, the negation of '∄'.
+            std::optional<QMLExpression::Operator> op = {};
+            std::optional<QMLExpression::Term> variable = {};
+        };
+
+        struct Level {
+            // The opening bracket, and the closing one it calls for; `none` for the formula itself.
+            size_t open = none;
+            TokenType closing = TokenType::NIL;
+            // Where the prefixes of the operand under way start on the shared stack.
+            size_t prefixes = 0;
+            // The first unary operator among those prefixes, and the outermost level around this
+            // one whose prefixes had one when it opened.
+            TokenType unary = TokenType::NIL;
+            size_t outerUnary = none;
+            // Where the connectives of the levels around this one end on `m_Operators`.
+            size_t operators = 0;
+            // Whether an operand comes next, rather than a connective.
+            bool operand = true;
+            Partial equivalence = {};
+            Partial implication = {};
+            Partial junction = {};
+            // The ∧ or ∨ before the operand under way, if the run of them has begun.
+            TokenType junctor = TokenType::NIL;
+            std::optional<QMLExpression::Operator> junctorOp = {};
+            // Whether a → or a ↔ comes before the operand under way.
+            bool implies = false;
+            bool equivalent = false;
+        };
+
+        TokenType at(size_t index) const
+        {
+            return index < m_Tokens.size() ? m_Tokens.type(index) : TokenType::EOI;
+        }
+
+        std::string_view literal(size_t index) const
+        {
+            return m_Tokens.literal(std::min(index, m_Tokens.size() - 1));
+        }
+
+        bool syncsAt(TokenType type) const
+        {
+            const int level = detail::connectiveLevel(type);
+            return level >= 0 && level <= m_Level;
+        }
+
+        ParseError errorAt(ErrorCode code, size_t index, std::string_view context = {}, TokenType expected = TokenType::NIL) const
+        {
+            return { .code = code, .index = index, .expected = expected, .actual = at(index), .context = context, .found = literal(index) };
+        }
+
+        /*
+         * Adds to an error raised at the token `at` what the rules around it add in `parse()`:
+         * the outermost unary operator of each prefix run under way turns it into
+         * EXPECTED_CLAUSE, and every connective whose right-hand side is under way records
+         * itself, from the innermost level out. `within` says whether the error is raised
+         * within the operand under way at the innermost level, rather than after it.
+         *
+         * Only the innermost level can still change; what the levels around it add was put
+         * on `m_Operators` as they were left, so an error costs no more than what it records.
+         */
+        ParseError enclose(ParseError error, size_t at, bool within) const
+        {
+            const size_t innermost = m_Levels.size() - 1;
+            // The outermost level whose unary operator rewrites the error; the levels within it add nothing.
+            size_t outer = m_Levels.back().outerUnary;
+            if (outer == none && within && m_Levels.back().unary != TokenType::NIL) {
+                outer = innermost;
+            }
+
+            if (outer != none) {
+                error = { .code = ErrorCode::EXPECTED_CLAUSE, .index = at, .actual = m_Levels[outer].unary };
+            }
+            if (within && (outer == none || outer == innermost)) {
+                pushOperators(error.operators, m_Levels.back());
+            }
+            const size_t end = outer == none || outer == innermost ? m_Operators.size() : m_Levels[outer + 1].operators;
+            error.operators.insert(error.operators.end(), m_Operators.rbegin() + static_cast<std::ptrdiff_t>(m_Operators.size() - end), m_Operators.rend());
+            return error;
+        }
+
+        // Appends the connectives whose right-hand side is under way at `level`, as `enclose()` records them.
+        static void pushOperators(std::vector<TokenType>& operators, const Level& level)
+        {
+            if (level.junctor != TokenType::NIL) {
+                operators.push_back(level.junctor);
+            }
+            if (level.implies) {
+                operators.push_back(TokenType::IF);
+            }
+            if (level.equivalent) {
+                operators.push_back(TokenType::EQ);
+            }
+        }
+
+        // Records an error; returns its position among the diagnostics.
+        size_t report(const ParseError& error)
+        {
+            m_Diagnostics.push_back({ .code = error.code, .begin = error.index, .end = error.index, .message = error.message() });
+            return m_Diagnostics.size() - 1;
+        }
+
+        /*
+         * Skips to the next token the current level can go on from: a connective the entry
+         * rule parses, a closing bracket or the end, and a ',' too if `commas` is set. Whole
+         * bracketed groups are skipped along the way.
+         */
+        size_t skip(size_t index, bool commas) const
+        {
+            size_t depth = 0;
+            for (;; ++index) {
+                const TokenType type = at(index);
+                if (type == TokenType::EOI) {
+                    return index;
+                }
+                if (type == TokenType::LPAREN || type == TokenType::LBRACKET) {
+                    ++depth;
+                }
+                else if (type == TokenType::RPAREN || type == TokenType::RBRACKET) {
+                    if (depth == 0) {
+                        return index;
+                    }
+                    --depth;
+                }
+                else if (depth == 0 && (syncsAt(type) || (commas && type == TokenType::COMMA))) {
+                    return index;
+                }
+            }
+        }
+
+        // Reports an error in the atomic formula at `start`, and skips from `resume`.
+        Partial fail(const ParseError& error, size_t start, size_t& index, size_t resume)
+        {
+            const size_t diagnostic = report(enclose(error, start, true));
+            index = skip(resume, false);
+            m_Diagnostics[diagnostic].end = index;
+            return std::nullopt;
+        }
+
+        Partial join(const std::optional<QMLExpression::Operator>& op, Partial lhs, Partial rhs) const
+        {
+            if (!lhs.has_value()) {
+                return rhs;
+            }
+            if (!rhs.has_value()) {
+                return lhs;
+            }
+            // Recovery sets no nesting limit, so what is dropped may be too deep to destroy recursively.
+            if (!op.has_value()) {
+                dismantle(std::move(*rhs));
+                return lhs;
+            }
+            return m_Builder.binary(*op, std::move(*lhs), std::move(*rhs));
+        }
+
+        // Parses the operand at `index` or the part of it that comes first. Returns true at the end.
+        bool operand(size_t& index)
+        {
+            const TokenType type = at(index);
+
+            if (detail::isUnaryOperator(type)) {
+                const auto op = m_Mapping(type);
+                if (!op.has_value()) {
+                    report(enclose({ .code = ErrorCode::MISSING_UNARY_MAP, .index = index, .actual = type }, index, true));
+                }
+                m_Prefixes.push_back({ .token = type, .op = op });
+                if (m_Levels.back().unary == TokenType::NIL) {
+                    m_Levels.back().unary = type;
+                }
+                ++index;
+                return false;
+            }
+
+            if (detail::isQuantifier(type)) {
+                if (at(index + 1) != TokenType::VARIABLE) {
+                    // The quantifier is dropped; what follows it is parsed as the operand.
+                    report(enclose(errorAt(ErrorCode::EXPECTED_VARIABLE, index + 1, literal(index), TokenType::VARIABLE), index, true));
+                    ++index;
+                    return false;
+                }
+                if (type == TokenType::NOT_EXISTS && !m_NotOp.has_value()) {
+                    report(enclose({ .code = ErrorCode::MISSING_MAP, .index = index, .actual = TokenType::NOT }, index, true));
+                }
+                m_Prefixes.push_back({ .token = type, .op = m_NotOp, .variable = m_Builder.term(literal(index + 1), TokenType::VARIABLE) });
+                index += 2;
+                return false;
+            }
+
+            if (type == TokenType::LPAREN || type == TokenType::LBRACKET) {
+                const TokenType closing = type == TokenType::LPAREN ? TokenType::RPAREN : TokenType::RBRACKET;
+                const size_t enclosing = m_Levels.size() - 1;
+                const Level& parent = m_Levels.back();
+                const size_t outerUnary = parent.outerUnary != none ? parent.outerUnary : parent.unary != TokenType::NIL ? enclosing : none;
+                // Stored outermost first and reversed within each level, so that `enclose()` reads them backwards.
+                const size_t begin = m_Operators.size();
+                pushOperators(m_Operators, parent);
+                std::reverse(m_Operators.begin() + static_cast<std::ptrdiff_t>(begin), m_Operators.end());
+                m_Levels.push_back({ .open = index, .closing = closing, .prefixes = m_Prefixes.size(), .outerUnary = outerUnary, .operators = m_Operators.size() });
+                ++index;
+                return false;
+            }
+
+            if (detail::isTerm(type)) {
+                done(atomic(index));
+                return false;
+            }
+
+            // No clause starts here: the operand is missing.
+            ParseError error = enclose(errorAt(ErrorCode::UNEXPECTED_TOKEN, index), index, true);
+            const size_t diagnostic = report(error);
+            if (!syncsAt(type) && type != TokenType::RPAREN && type != TokenType::RBRACKET && type != TokenType::EOI) {
+                index = skip(index, false);
+            }
+            m_Diagnostics[diagnostic].end = index;
+            done(std::nullopt);
+            return false;
+        }
+
+        Partial atomic(size_t& index)
+        {
+            const size_t start = index;
+            const TokenType next = at(index + 1);
+
+            if (next == TokenType::LPAREN) {
+                if (at(index) != TokenType::IDENTIFIER) {
+                    return fail(errorAt(ErrorCode::UNEXPECTED_TOKEN, index), start, index, index + 1);
+                }
+                return predication(index);
+            }
+
+            if (next == TokenType::ID || next == TokenType::NEQ) {
+                if (!detail::isTerm(at(index + 2))) {
+                    // As in `parse()`, an inequality reports the '≠' itself as what was found.
+                    const size_t offending = next == TokenType::ID ? index + 2 : index + 1;
+                    return fail(errorAt(ErrorCode::EXPECTED_RHS_TERM, offending, literal(index + 1)), start, index, index + 2);
+                }
+                QMLExpression::Expression identity = m_Builder.identity(m_Builder.term(literal(index), at(index)), m_Builder.term(literal(index + 2), at(index + 2)));
+                index += 3;
+                if (next == TokenType::ID) {
+                    return identity;
+                }
+                if (m_NotOp.has_value()) {
+                    return m_Builder.unary(*m_NotOp, std::move(identity));
+                }
+                report(enclose({ .code = ErrorCode::MISSING_MAP, .index = index, .actual = TokenType::NOT }, start, true));
+                return std::nullopt;
+            }
+
+            return fail(errorAt(ErrorCode::EXPECTED_ATOMIC_OPERATOR, index + 1, literal(index)), start, index, index + 1);
+        }
+
+        /*
+         * Parses the argument list of the predicate at `index`, going on from the next ',' past
+         * a malformed argument. The list ends at its ')', or without one at a token the
+         * current level goes on from.
+         */
+        Partial predication(size_t& index)
+        {
+            const size_t start = index;
+            bool failed = false;
+            ExpressionBuilder::Arguments arguments;
+
+            index += 2;
+            for (bool first = true;; first = false) {
+                const auto malformed = [&](const ParseError& error, size_t resume) {
+                    const size_t diagnostic = report(enclose(error, start, true));
+                    index = skip(resume, true);
+                    m_Diagnostics[diagnostic].end = index;
+                    failed = true;
+                };
+
+                if (!detail::isTerm(at(index))) {
+                    malformed(errorAt(ErrorCode::EXPECTED_TERM, index, literal(index - 1)), index);
+                }
+                else if (at(index + 1) != TokenType::COMMA && at(index + 1) != TokenType::RPAREN) {
+                    malformed(first ? errorAt(ErrorCode::EXPECTED_SEPARATOR, index + 1, literal(index)) : errorAt(ErrorCode::EXPECTED_ARGUMENT_LIST_END, index + 1, {}, TokenType::RPAREN), index + 1);
+                }
+                else {
+                    m_Builder.argument(arguments, m_Builder.term(literal(index), at(index)));
+                    ++index;
+                }
+
+                if (at(index) == TokenType::COMMA) {
+                    ++index;
+                    continue;
+                }
+                if (at(index) == TokenType::RPAREN) {
+                    ++index;
+                }
+                break;
+            }
+
+            if (failed) {
+                return std::nullopt;
+            }
+            return m_Builder.predication(literal(start), std::move(arguments));
+        }
+
+        // Handles the token after an operand. Returns true at the end.
+        bool after(size_t& index)
+        {
+            const TokenType type = at(index);
+
+            if (syncsAt(type)) {
+                connective(type, index);
+                ++index;
+                return false;
+            }
+
+            if (type == TokenType::RPAREN || type == TokenType::RBRACKET) {
+                close(type, index);
+                return false;
+            }
+
+            if (type == TokenType::EOI) {
+                while (m_Levels.size() > 1) {
+                    const Level& level = m_Levels.back();
+                    report(enclose(errorAt(ErrorCode::EXPECTED_CLOSING, index, literal(level.open), level.closing), index, false));
+                    pop();
+                }
+                return true;
+            }
+
+            // A complete operand is followed by a token that cannot go on from it.
+            const Level& level = m_Levels.back();
+            const ParseError error = level.open == none
+                ? errorAt(ErrorCode::UNEXPECTED_SYMBOL, index)
+                : enclose(errorAt(ErrorCode::EXPECTED_CLOSING, index, literal(level.open), level.closing), index, false);
+            const size_t diagnostic = report(error);
+            index = skip(index, false);
+            m_Diagnostics[diagnostic].end = index;
+            return false;
+        }
+
+        void connective(TokenType type, size_t index)
+        {
+            Level& level = m_Levels.back();
+
+            if (detail::connectiveLevel(type) == 0) {
+                level.junctorOp = m_Mapping(type);
+                if (!level.junctorOp.has_value()) {
+                    report(enclose({ .code = ErrorCode::MISSING_MAP, .index = index, .actual = type }, index, false));
+                }
+                level.junctor = type;
+                level.operand = true;
+                return;
+            }
+
+            if (!(type == TokenType::IF ? m_IfOp : m_EqOp).has_value()) {
+                report(enclose({ .code = ErrorCode::MISSING_MAP, .index = index, .actual = type }, index, false));
+            }
+            level.implication = join(m_IfOp, std::exchange(level.implication, std::nullopt), std::exchange(level.junction, std::nullopt));
+            level.junctor = TokenType::NIL;
+            level.junctorOp.reset();
+            level.implies = true;
+            if (type == TokenType::EQ) {
+                level.equivalence = join(m_EqOp, std::exchange(level.equivalence, std::nullopt), std::exchange(level.implication, std::nullopt));
+                level.implies = false;
+                level.equivalent = true;
+            }
+            level.operand = true;
+        }
+
+        // Ends the innermost bracket at the closing bracket `type`, whether or not it matches.
+        void close(TokenType type, size_t& index)
+        {
+            if (m_Levels.size() == 1) {
+                report(errorAt(ErrorCode::UNEXPECTED_SYMBOL, index));
+                m_Diagnostics.back().end = ++index;
+                return;
+            }
+
+            bool consumed = true;
+            const Level& level = m_Levels.back();
+            if (type != level.closing) {
+                report(enclose(errorAt(ErrorCode::EXPECTED_CLOSING, index, literal(level.open), level.closing), index, false));
+                // A bracket that closes an outer one is left for it.
+                consumed = std::none_of(m_Levels.begin() + 1, m_Levels.end() - 1, [&](const Level& outer) { return outer.closing == type; });
+            }
+            pop();
+            if (consumed) {
+                ++index;
+            }
+        }
+
+        // Applies the prefixes under way to the operand just parsed, and folds it in.
+        void done(Partial value)
+        {
+            Level& level = m_Levels.back();
+            while (m_Prefixes.size() > level.prefixes) {
+                Prefix& prefix = m_Prefixes.back();
+                if (value.has_value() && !prefix.variable.has_value()) {
+                    if (prefix.op.has_value()) {
+                        value = m_Builder.unary(*prefix.op, std::move(*value));
+                    }
+                    else {
+                        dismantle(std::move(*value));
+                        value.reset();
+                    }
+                }
+                else if (value.has_value()) {
+                    const QMLExpression::Quantifier quantifier = prefix.token == TokenType::FORALL ? QMLExpression::Quantifier::UNIVERSAL : QMLExpression::Quantifier::EXISTENTIAL;
+                    QMLExpression::Expression quantified = m_Builder.quantification(quantifier, std::move(*prefix.variable), std::move(*value));
+                    if (prefix.token != TokenType::NOT_EXISTS) {
+                        value = std::move(quantified);
+                    }
+                    else if (prefix.op.has_value()) {
+                        value = m_Builder.unary(*prefix.op, std::move(quantified));
+                    }
+                    else {
+                        dismantle(std::move(quantified));
+                        value.reset();
+                    }
+                }
+                m_Prefixes.pop_back();
+            }
+            level.unary = TokenType::NIL;
+            level.junction = join(level.junctorOp, std::exchange(level.junction, std::nullopt), std::move(value));
+            level.operand = false;
+        }
+
+        Partial finish()
+        {
+            Level& level = m_Levels.back();
+            level.implication = join(m_IfOp, std::exchange(level.implication, std::nullopt), std::exchange(level.junction, std::nullopt));
+            return join(m_EqOp, std::exchange(level.equivalence, std::nullopt), std::exchange(level.implication, std::nullopt));
+        }
+
+        // Ends the innermost bracket, handing what it parsed to the level around it.
+        void pop()
+        {
+            Partial value = finish();
+            m_Levels.pop_back();
+            m_Operators.resize(m_Levels.back().operators);
+            done(std::move(value));
+        }
+
+        const TokenBuffer& m_Tokens;
+        const Parser::MappingFunction& m_Mapping;
+        ExpressionBuilder m_Builder;
+        int m_Level;
+        std::optional<QMLExpression::Operator> m_IfOp;
+        std::optional<QMLExpression::Operator> m_EqOp;
+        std::optional<QMLExpression::Operator> m_NotOp;
+        std::vector<Level> m_Levels;
+        std::vector<Prefix> m_Prefixes;
+        // The connectives under way at every level but the innermost (see `enclose()`).
+        std::vector<TokenType> m_Operators;
+        std::vector<Diagnostic> m_Diagnostics;
+    };
+
+    // Parses from an entry rule there is no recovering in, stopping at the first error.
+    RecoveredParse parseOnce(const TokenBuffer& tokens, Rule entry, Parser::MappingFunction mappingFunction)
+    {
+        using Reporter = BasicParser<Parser::MappingFunction, Rule::DYNAMIC, ParseError>;
+        auto result = Reporter(tokens, std::move(mappingFunction)).parse(Reporter::entryPointFor(entry));
+        if (result.has_value()) {
+            return { .expression = OwnedExpression(std::move(result).value()), .diagnostics = {} };
+        }
+        const ParseError& error = result.error();
+        return { .expression = std::nullopt, .diagnostics = { { .code = error.code, .begin = error.index, .end = error.index, .message = error.message() } } };
+    }
+}
+
+RecoveredParse parse_recovering(std::string_view formula, Rule entry, Parser::MappingFunction mappingFunction)
+{
+    const detail::StatsScope scope;
+    // Borrowed for the call, so that checking formula after formula stops allocating tokens.
+    const detail::Scratch<TokenBuffer> scratch;
+    const TokenBuffer& tokens = *scratch;
+    lex(formula, *scratch);
+
+    if (tokens.empty()) {
+        const Diagnostic empty{ .code = ErrorCode::EMPTY_INPUT, .begin = 0, .end = 0, .message = ParseError{ .code = ErrorCode::EMPTY_INPUT }.message() };
+        return { .expression = std::nullopt, .diagnostics = { empty } };
+    }
+    if (detail::connectiveLevel(entry) < 0 && entry != Rule::CLAUSE) {
+        return parseOnce(tokens, entry, std::move(mappingFunction));
+    }
+    return Recovery(tokens, entry, mappingFunction).run();
+}
+
+}
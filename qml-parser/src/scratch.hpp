@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "token.hpp"
+
+/*
+ * Buffers that the free functions lex into and throw away once they return. Each thread
+ * keeps a few of them on a free list, so that handling formula after formula reuses their
+ * storage. A call borrows one for as long as it runs, so that a mapping or an entry point
+ * that parses again, on the same thread, borrows another instead of overwriting the first.
+ * A buffer that has grown past `scratch_limit` bytes is let go of when it is given back, so
+ * that one very long formula does not pin its storage for the life of the thread.
+ */
+namespace iif_sadaf::talk::QMLParser::detail {
+
+inline constexpr size_t scratch_limit = size_t(1) << 20;
+inline constexpr size_t scratch_kept = 4;
+
+inline size_t footprint(const TokenBuffer& tokens)
+{
+    return tokens.footprint();
+}
+
+template<typename T>
+size_t footprint(const std::vector<T>& list)
+{
+    return list.capacity() * sizeof(T);
+}
+
+template<typename T>
+class Scratch
+{
+public:
+    Scratch()
+        : m_Object(take())
+    {
+    }
+
+    ~Scratch()
+    {
+        std::vector<std::unique_ptr<T>>& free = freeList();
+        if (footprint(*m_Object) <= scratch_limit && free.size() < scratch_kept) {
+            free.push_back(std::move(m_Object));
+        }
+    }
+
+    Scratch(const Scratch&) = delete;
+    Scratch& operator=(const Scratch&) = delete;
+
+    T& operator*() const { return *m_Object; }
+    T* operator->() const { return m_Object.get(); }
+
+private:
+    static std::vector<std::unique_ptr<T>>& freeList()
+    {
+        thread_local std::vector<std::unique_ptr<T>> free;
+        return free;
+    }
+
+    static std::unique_ptr<T> take()
+    {
+        std::vector<std::unique_ptr<T>>& free = freeList();
+        if (free.empty()) {
+            return std::make_unique<T>();
+        }
+        std::unique_ptr<T> object = std::move(free.back());
+        free.pop_back();
+        return object;
+    }
+
+    std::unique_ptr<T> m_Object;
+};
+
+}
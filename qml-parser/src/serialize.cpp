@@ -0,0 +1,655 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "serialize.hpp"
+
+#include <array>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include "builder.hpp"
+#include "symbols.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    using QMLExpression::Expression;
+    using QMLExpression::Operator;
+    using QMLExpression::Quantifier;
+    using QMLExpression::Term;
+    using Kind = ExpressionArchive::Kind;
+
+    // The header: the magic number, the version, five counts and a reserved word.
+    constexpr std::array<unsigned char, 4> magic = { 'Q', 'M', 'L', 'B' };
+    constexpr size_t header_size = 8 * sizeof(uint32_t);
+    // A node: its kind and tag, then two operands.
+    constexpr size_t node_size = 3 * sizeof(uint32_t);
+
+    // The values of the tags, in the order they are numbered in the format.
+    constexpr std::array operators = {
+        Operator::NEGATION, Operator::CONJUNCTION, Operator::DISJUNCTION, Operator::CONDITIONAL,
+        Operator::BICONDITIONAL, Operator::NECESSITY, Operator::POSSIBILITY, Operator::DEONTIC_NECESSITY,
+        Operator::DEONTIC_POSSIBILITY, Operator::EPISTEMIC_NECESSITY, Operator::EPISTEMIC_POSSIBILITY,
+    };
+    constexpr std::array quantifiers = { Quantifier::UNIVERSAL, Quantifier::EXISTENTIAL };
+    constexpr std::array term_types = { Term::Type::VARIABLE, Term::Type::CONSTANT };
+
+    template<typename T, size_t N>
+    uint32_t tagOf(const std::array<T, N>& values, T value)
+    {
+        for (uint32_t i = 0; i < N; ++i) {
+            if (values[i] == value) {
+                return i;
+            }
+        }
+        throw std::invalid_argument("Value has no encoding in the archive format");
+    }
+
+    void put(std::vector<std::byte>& out, uint32_t word)
+    {
+        for (int shift = 0; shift < 32; shift += 8) {
+            out.push_back(static_cast<std::byte>((word >> shift) & 0xFF));
+        }
+    }
+
+    uint32_t get(const std::byte* in)
+    {
+        uint32_t word = 0;
+        for (int i = 3; i >= 0; --i) {
+            word = (word << 8) | std::to_integer<uint32_t>(in[i]);
+        }
+        return word;
+    }
+
+    const void* address(const Expression& expression)
+    {
+        return std::visit([](const auto& node) -> const void* { return node.get(); }, expression);
+    }
+
+    // Numbers the nodes of the expressions it is given, in postorder, writing each once.
+    class Writer
+    {
+    public:
+        uint32_t write(const Expression& root);
+        std::vector<std::byte> finish(std::span<const uint32_t> roots);
+
+    private:
+        uint32_t node(Kind kind, uint32_t tag, uint32_t first, uint32_t second);
+        uint32_t term(const Term& term);
+        uint32_t symbol(std::string_view name);
+
+        SymbolTable m_Symbols;
+        std::unordered_map<const void*, uint32_t> m_Written;
+        std::unordered_map<uint64_t, uint32_t> m_Terms;
+        std::vector<std::array<uint32_t, 3>> m_Nodes;
+        std::vector<uint32_t> m_Arguments;
+    };
+
+    uint32_t Writer::node(Kind kind, uint32_t tag, uint32_t first, uint32_t second)
+    {
+        if (m_Nodes.size() >= std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Too many nodes for the archive format");
+        }
+        m_Nodes.push_back({ static_cast<uint32_t>(kind) | (tag << 8), first, second });
+        return static_cast<uint32_t>(m_Nodes.size() - 1);
+    }
+
+    uint32_t Writer::symbol(std::string_view name)
+    {
+        const SymbolTable::Symbol symbol = m_Symbols.intern(name);
+        if (symbol == std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Too many names for the archive format");
+        }
+        return symbol;
+    }
+
+    uint32_t Writer::term(const Term& term)
+    {
+        const uint32_t type = tagOf(term_types, term.type);
+        const uint64_t key = (static_cast<uint64_t>(symbol(term.literal)) << 1) | type;
+        if (const auto it = m_Terms.find(key); it != m_Terms.end()) {
+            return it->second;
+        }
+        const uint32_t index = node(Kind::TERM, type, static_cast<uint32_t>(key >> 1), 0);
+        m_Terms.emplace(key, index);
+        return index;
+    }
+
+    uint32_t Writer::write(const Expression& root)
+    {
+        // A node is visited twice: first to schedule its subformulas, then, once their
+        // indexes are on `done`, to write it.
+        struct Visit {
+            const Expression* expression;
+            bool expanded;
+        };
+
+        std::vector<Visit> pending{ { &root, false } };
+        std::vector<uint32_t> done;
+
+        while (!pending.empty()) {
+            const Visit visit = pending.back();
+            pending.pop_back();
+            const Expression& expression = *visit.expression;
+
+            if (!visit.expanded) {
+                if (const auto it = m_Written.find(address(expression)); it != m_Written.end()) {
+                    done.push_back(it->second);
+                    continue;
+                }
+                pending.push_back({ &expression, true });
+                if (const auto* unary = std::get_if<std::shared_ptr<QMLExpression::UnaryNode>>(&expression)) {
+                    pending.push_back({ &(*unary)->scope, false });
+                }
+                else if (const auto* binary = std::get_if<std::shared_ptr<QMLExpression::BinaryNode>>(&expression)) {
+                    pending.push_back({ &(*binary)->rhs, false });
+                    pending.push_back({ &(*binary)->lhs, false });
+                }
+                else if (const auto* quantification = std::get_if<std::shared_ptr<QMLExpression::QuantificationNode>>(&expression)) {
+                    pending.push_back({ &(*quantification)->scope, false });
+                }
+                continue;
+            }
+
+            uint32_t index = 0;
+            if (const auto* unary = std::get_if<std::shared_ptr<QMLExpression::UnaryNode>>(&expression)) {
+                const uint32_t scope = done.back();
+                done.pop_back();
+                index = node(Kind::UNARY, tagOf(operators, (*unary)->op), scope, 0);
+            }
+            else if (const auto* binary = std::get_if<std::shared_ptr<QMLExpression::BinaryNode>>(&expression)) {
+                const uint32_t rhs = done.back();
+                done.pop_back();
+                const uint32_t lhs = done.back();
+                done.pop_back();
+                index = node(Kind::BINARY, tagOf(operators, (*binary)->op), lhs, rhs);
+            }
+            else if (const auto* quantification = std::get_if<std::shared_ptr<QMLExpression::QuantificationNode>>(&expression)) {
+                const uint32_t scope = done.back();
+                done.pop_back();
+                const uint32_t variable = term((*quantification)->variable);
+                index = node(Kind::QUANTIFICATION, tagOf(quantifiers, (*quantification)->quantifier), variable, scope);
+            }
+            else if (const auto* identity = std::get_if<std::shared_ptr<QMLExpression::IdentityNode>>(&expression)) {
+                const uint32_t lhs = term((*identity)->lhs);
+                const uint32_t rhs = term((*identity)->rhs);
+                index = node(Kind::IDENTITY, 0, lhs, rhs);
+            }
+            else {
+                const auto& predication = std::get<std::shared_ptr<QMLExpression::PredicationNode>>(expression);
+                const size_t first = m_Arguments.size();
+                m_Arguments.push_back(static_cast<uint32_t>(predication->arguments.size()));
+                for (const Term& argument : predication->arguments) {
+                    m_Arguments.push_back(term(argument));
+                }
+                if (m_Arguments.size() > std::numeric_limits<uint32_t>::max()) {
+                    throw std::length_error("Too many arguments for the archive format");
+                }
+                index = node(Kind::PREDICATION, 0, symbol(predication->predicate), static_cast<uint32_t>(first));
+            }
+
+            m_Written.emplace(address(expression), index);
+            done.push_back(index);
+        }
+
+        return done.back();
+    }
+
+    std::vector<std::byte> Writer::finish(std::span<const uint32_t> roots)
+    {
+        const uint32_t symbolCount = static_cast<uint32_t>(m_Symbols.size());
+        size_t nameBytes = 0;
+        for (uint32_t i = 0; i < symbolCount; ++i) {
+            nameBytes += m_Symbols.name(i).size();
+        }
+        if (roots.size() > std::numeric_limits<uint32_t>::max() || nameBytes > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Too many expressions for the archive format");
+        }
+
+        std::vector<std::byte> out;
+        out.reserve(header_size + sizeof(uint32_t) * (roots.size() + m_Arguments.size() + symbolCount + 1) + node_size * m_Nodes.size() + nameBytes);
+
+        for (const unsigned char c : magic) {
+            out.push_back(static_cast<std::byte>(c));
+        }
+        put(out, ExpressionArchive::version);
+        put(out, static_cast<uint32_t>(roots.size()));
+        put(out, static_cast<uint32_t>(m_Nodes.size()));
+        put(out, static_cast<uint32_t>(m_Arguments.size()));
+        put(out, symbolCount);
+        put(out, static_cast<uint32_t>(nameBytes));
+        put(out, 0);
+
+        for (const uint32_t root : roots) {
+            put(out, root);
+        }
+        for (const auto& node : m_Nodes) {
+            for (const uint32_t word : node) {
+                put(out, word);
+            }
+        }
+        for (const uint32_t argument : m_Arguments) {
+            put(out, argument);
+        }
+
+        uint32_t offset = 0;
+        put(out, offset);
+        for (uint32_t i = 0; i < symbolCount; ++i) {
+            offset += static_cast<uint32_t>(m_Symbols.name(i).size());
+            put(out, offset);
+        }
+        for (uint32_t i = 0; i < symbolCount; ++i) {
+            for (const char c : m_Symbols.name(i)) {
+                out.push_back(static_cast<std::byte>(c));
+            }
+        }
+
+        return out;
+    }
+
+    bool isTerm(Kind kind)
+    {
+        return kind == Kind::TERM;
+    }
+}
+
+std::vector<std::byte> serialize(std::span<const QMLExpression::Expression> expressions)
+{
+    Writer writer;
+    std::vector<uint32_t> roots;
+    roots.reserve(expressions.size());
+    for (const Expression& expression : expressions) {
+        roots.push_back(writer.write(expression));
+    }
+    return writer.finish(roots);
+}
+
+/**
+ * @brief Checks that `bytes` hold an archive, and opens it.
+ *
+ * Every index in the archive is checked to point where it should, so that no archive that
+ * opens can make the reader go out of bounds, however its bytes were produced.
+ *
+ * @param bytes The encoding, which must outlive the archive.
+ * @return The archive, or a message telling what is wrong with the bytes.
+ */
+std::expected<ExpressionArchive, std::string> ExpressionArchive::open(std::span<const std::byte> bytes)
+{
+    if (bytes.size() < header_size) {
+        return std::unexpected("Malformed archive: truncated header");
+    }
+    for (size_t i = 0; i < magic.size(); ++i) {
+        if (std::to_integer<unsigned char>(bytes[i]) != magic[i]) {
+            return std::unexpected("Malformed archive: bad magic number");
+        }
+    }
+    if (const uint32_t found = get(bytes.data() + 4); found != version) {
+        return std::unexpected(std::format("Unsupported archive version {} (expected {})", found, version));
+    }
+
+    ExpressionArchive archive;
+    archive.m_Bytes = bytes;
+    archive.m_ExpressionCount = get(bytes.data() + 8);
+    archive.m_NodeCount = get(bytes.data() + 12);
+    archive.m_ArgumentCount = get(bytes.data() + 16);
+    archive.m_SymbolCount = get(bytes.data() + 20);
+    const uint32_t nameBytes = get(bytes.data() + 24);
+
+    // Computed in 64 bits, which the 32-bit counts cannot overflow.
+    const uint64_t words = uint64_t{ archive.m_ExpressionCount } + archive.m_ArgumentCount + archive.m_SymbolCount + 1;
+    const uint64_t expected = header_size + sizeof(uint32_t) * words + node_size * uint64_t{ archive.m_NodeCount } + nameBytes;
+    if (expected != bytes.size()) {
+        return std::unexpected(std::format("Malformed archive: expected {} bytes but got {}", expected, bytes.size()));
+    }
+
+    archive.m_Roots = header_size;
+    archive.m_Nodes = archive.m_Roots + sizeof(uint32_t) * archive.m_ExpressionCount;
+    archive.m_Arguments = archive.m_Nodes + node_size * archive.m_NodeCount;
+    archive.m_Offsets = archive.m_Arguments + sizeof(uint32_t) * archive.m_ArgumentCount;
+    archive.m_Names = archive.m_Offsets + sizeof(uint32_t) * (archive.m_SymbolCount + 1);
+
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i <= archive.m_SymbolCount; ++i) {
+        const uint32_t offset = archive.word(archive.m_Offsets + sizeof(uint32_t) * i);
+        if (offset < previous || (i == 0 && offset != 0)) {
+            return std::unexpected("Malformed archive: bad name offsets");
+        }
+        previous = offset;
+    }
+    if (previous != nameBytes) {
+        return std::unexpected("Malformed archive: bad name offsets");
+    }
+
+    std::vector<Kind> kinds(archive.m_NodeCount);
+    for (uint32_t i = 0; i < archive.m_NodeCount; ++i) {
+        const uint32_t head = archive.nodeField(i, 0);
+        const uint32_t tag = head >> 8;
+        const uint32_t first = archive.nodeField(i, 1);
+        const uint32_t second = archive.nodeField(i, 2);
+        const auto below = [&](uint32_t child, bool term) { return child < i && isTerm(kinds[child]) == term; };
+
+        bool valid = false;
+        switch (head & 0xFF) {
+        case static_cast<uint32_t>(Kind::TERM):
+            valid = tag < term_types.size() && first < archive.m_SymbolCount && second == 0;
+            break;
+        case static_cast<uint32_t>(Kind::UNARY):
+            valid = tag < operators.size() && below(first, false) && second == 0;
+            break;
+        case static_cast<uint32_t>(Kind::BINARY):
+            valid = tag < operators.size() && below(first, false) && below(second, false);
+            break;
+        case static_cast<uint32_t>(Kind::QUANTIFICATION):
+            valid = tag < quantifiers.size() && below(first, true) && below(second, false);
+            break;
+        case static_cast<uint32_t>(Kind::IDENTITY):
+            valid = tag == 0 && below(first, true) && below(second, true);
+            break;
+        case static_cast<uint32_t>(Kind::PREDICATION):
+            valid = tag == 0 && first < archive.m_SymbolCount && second < archive.m_ArgumentCount;
+            if (valid) {
+                const uint64_t arity = archive.word(archive.m_Arguments + sizeof(uint32_t) * second);
+                valid = second + arity < archive.m_ArgumentCount;
+                for (uint64_t k = 0; valid && k < arity; ++k) {
+                    valid = below(archive.argument(i, k), true);
+                }
+            }
+            break;
+        default:
+            break;
+        }
+        if (!valid) {
+            return std::unexpected(std::format("Malformed archive: bad node {}", i));
+        }
+        kinds[i] = static_cast<Kind>(head & 0xFF);
+    }
+
+    for (uint32_t i = 0; i < archive.m_ExpressionCount; ++i) {
+        const uint32_t root = archive.word(archive.m_Roots + sizeof(uint32_t) * i);
+        if (root >= archive.m_NodeCount || isTerm(kinds[root])) {
+            return std::unexpected(std::format("Malformed archive: bad root {}", i));
+        }
+    }
+
+    return archive;
+}
+
+/**
+ * @brief Gives the number of expressions in the archive.
+ */
+size_t ExpressionArchive::size() const
+{
+    return m_ExpressionCount;
+}
+
+/**
+ * @brief Gives the root node of the `i`-th expression, read in place.
+ * @throws std::out_of_range if there is no such expression.
+ */
+auto ExpressionArchive::root(size_t i) const -> Node
+{
+    if (i >= m_ExpressionCount) {
+        throw std::out_of_range("ExpressionArchive has no such expression");
+    }
+    return Node(this, word(m_Roots + sizeof(uint32_t) * i));
+}
+
+/**
+ * @brief Rebuilds every expression in the archive.
+ *
+ * Each node is built once, so nodes that were shared when written are shared again.
+ *
+ * @param resource Where to allocate the nodes, as with `ExpressionBuilder::setMemoryResource()`.
+ * @return The expressions, in the order they were written.
+ */
+std::vector<QMLExpression::Expression> ExpressionArchive::expressions(std::pmr::memory_resource* resource) const
+{
+    ExpressionBuilder builder;
+    builder.setMemoryResource(resource);
+
+    // Terms and formulas are numbered together; each holds a slot in the vector of its kind.
+    std::vector<Expression> formulas;
+    std::vector<Term> terms;
+    std::vector<uint32_t> slots(m_NodeCount);
+    formulas.reserve(m_NodeCount);
+
+    for (uint32_t i = 0; i < m_NodeCount; ++i) {
+        const Node node(this, i);
+        const uint32_t first = nodeField(i, 1);
+        const uint32_t second = nodeField(i, 2);
+
+        switch (node.kind()) {
+        case Kind::TERM:
+            slots[i] = static_cast<uint32_t>(terms.size());
+            terms.emplace_back(std::string(node.name()), node.termType());
+            continue;
+        case Kind::UNARY:
+            formulas.push_back(builder.unary(node.op(), formulas[slots[first]]));
+            break;
+        case Kind::BINARY:
+            formulas.push_back(builder.binary(node.op(), formulas[slots[first]], formulas[slots[second]]));
+            break;
+        case Kind::QUANTIFICATION:
+            formulas.push_back(builder.quantification(node.quantifier(), terms[slots[first]], formulas[slots[second]]));
+            break;
+        case Kind::IDENTITY:
+            formulas.push_back(builder.identity(terms[slots[first]], terms[slots[second]]));
+            break;
+        case Kind::PREDICATION: {
+            ExpressionBuilder::Arguments arguments;
+            arguments.reserve(node.arity());
+            for (size_t k = 0; k < node.arity(); ++k) {
+                arguments.push_back(terms[slots[argument(i, k)]]);
+            }
+            formulas.push_back(builder.predication(node.name(), std::move(arguments)));
+            break;
+        }
+        }
+        slots[i] = static_cast<uint32_t>(formulas.size() - 1);
+    }
+
+    std::vector<Expression> result;
+    result.reserve(m_ExpressionCount);
+    for (uint32_t i = 0; i < m_ExpressionCount; ++i) {
+        result.push_back(formulas[slots[word(m_Roots + sizeof(uint32_t) * i)]]);
+    }
+    return result;
+}
+
+/**
+ * @brief Rebuilds the `i`-th expression in the archive, and only its nodes.
+ * @param i The position of the expression.
+ * @param resource Where to allocate the nodes, as with `ExpressionBuilder::setMemoryResource()`.
+ * @return The expression.
+ * @throws std::out_of_range if there is no such expression.
+ */
+QMLExpression::Expression ExpressionArchive::expression(size_t i, std::pmr::memory_resource* resource) const
+{
+    ExpressionBuilder builder;
+    builder.setMemoryResource(resource);
+
+    const auto term = [](const Node& node) { return Term(std::string(node.name()), node.termType()); };
+
+    // A node is visited twice: first to schedule its subformulas, then, once they are built,
+    // to build it. Shared nodes are built once.
+    struct Visit {
+        uint32_t index;
+        bool expanded;
+    };
+
+    std::unordered_map<uint32_t, Expression> built;
+    std::vector<Visit> pending{ { root(i).m_Index, false } };
+    std::vector<Expression> done;
+
+    while (!pending.empty()) {
+        const Visit visit = pending.back();
+        pending.pop_back();
+        const Node node(this, visit.index);
+
+        if (!visit.expanded) {
+            if (const auto it = built.find(visit.index); it != built.end()) {
+                done.push_back(it->second);
+                continue;
+            }
+            pending.push_back({ visit.index, true });
+            switch (node.kind()) {
+            case Kind::BINARY:
+                pending.push_back({ nodeField(visit.index, 2), false });
+                [[fallthrough]];
+            case Kind::UNARY:
+                pending.push_back({ nodeField(visit.index, 1), false });
+                break;
+            case Kind::QUANTIFICATION:
+                pending.push_back({ nodeField(visit.index, 2), false });
+                break;
+            default:
+                break;
+            }
+            continue;
+        }
+
+        Expression expression;
+        switch (node.kind()) {
+        case Kind::UNARY: {
+            Expression scope = std::move(done.back());
+            done.pop_back();
+            expression = builder.unary(node.op(), std::move(scope));
+            break;
+        }
+        case Kind::BINARY: {
+            Expression rhs = std::move(done.back());
+            done.pop_back();
+            Expression lhs = std::move(done.back());
+            done.pop_back();
+            expression = builder.binary(node.op(), std::move(lhs), std::move(rhs));
+            break;
+        }
+        case Kind::QUANTIFICATION: {
+            Expression scope = std::move(done.back());
+            done.pop_back();
+            expression = builder.quantification(node.quantifier(), term(node.child(0)), std::move(scope));
+            break;
+        }
+        case Kind::IDENTITY:
+            expression = builder.identity(term(node.child(0)), term(node.child(1)));
+            break;
+        default: {
+            ExpressionBuilder::Arguments arguments;
+            arguments.reserve(node.arity());
+            for (size_t k = 0; k < node.arity(); ++k) {
+                arguments.push_back(term(node.child(k)));
+            }
+            expression = builder.predication(node.name(), std::move(arguments));
+            break;
+        }
+        }
+
+        built.emplace(visit.index, expression);
+        done.push_back(std::move(expression));
+    }
+
+    return std::move(done.back());
+}
+
+uint32_t ExpressionArchive::word(size_t offset) const
+{
+    return get(m_Bytes.data() + offset);
+}
+
+uint32_t ExpressionArchive::nodeField(uint32_t node, size_t field) const
+{
+    return word(m_Nodes + node_size * node + sizeof(uint32_t) * field);
+}
+
+// The `i`-th term of the argument list of a predication.
+uint32_t ExpressionArchive::argument(uint32_t node, size_t i) const
+{
+    return word(m_Arguments + sizeof(uint32_t) * (nodeField(node, 2) + 1 + i));
+}
+
+std::string_view ExpressionArchive::symbol(uint32_t symbol) const
+{
+    const uint32_t begin = word(m_Offsets + sizeof(uint32_t) * symbol);
+    const uint32_t end = word(m_Offsets + sizeof(uint32_t) * (symbol + 1));
+    return { reinterpret_cast<const char*>(m_Bytes.data() + m_Names + begin), end - begin };
+}
+
+ExpressionArchive::Node::Node(const ExpressionArchive* archive, uint32_t index)
+    : m_Archive(archive), m_Index(index)
+{
+}
+
+auto ExpressionArchive::Node::kind() const -> Kind
+{
+    return static_cast<Kind>(m_Archive->nodeField(m_Index, 0) & 0xFF);
+}
+
+/**
+ * @brief Gives the operator of a unary or binary node.
+ */
+QMLExpression::Operator ExpressionArchive::Node::op() const
+{
+    return operators[m_Archive->nodeField(m_Index, 0) >> 8];
+}
+
+/**
+ * @brief Gives the quantifier of a quantification node.
+ */
+QMLExpression::Quantifier ExpressionArchive::Node::quantifier() const
+{
+    return quantifiers[m_Archive->nodeField(m_Index, 0) >> 8];
+}
+
+/**
+ * @brief Gives the type of a term node.
+ */
+QMLExpression::Term::Type ExpressionArchive::Node::termType() const
+{
+    return term_types[m_Archive->nodeField(m_Index, 0) >> 8];
+}
+
+/**
+ * @brief Gives the literal of a term node, or the predicate of a predication node.
+ * @return A view into the bytes of the archive.
+ */
+std::string_view ExpressionArchive::Node::name() const
+{
+    return m_Archive->symbol(m_Archive->nodeField(m_Index, 1));
+}
+
+/**
+ * @brief Gives the number of children of the node.
+ */
+size_t ExpressionArchive::Node::arity() const
+{
+    switch (kind()) {
+    case Kind::TERM: return 0;
+    case Kind::UNARY: return 1;
+    case Kind::PREDICATION: return m_Archive->word(m_Archive->m_Arguments + sizeof(uint32_t) * m_Archive->nodeField(m_Index, 2));
+    default: return 2;
+    }
+}
+
+/**
+ * @brief Gives the `i`-th child of the node, as listed in the description of `Node`.
+ * @throws std::out_of_range if the node has no such child.
+ */
+auto ExpressionArchive::Node::child(size_t i) const -> Node
+{
+    if (i >= arity()) {
+        throw std::out_of_range("ExpressionArchive node has no such child");
+    }
+    if (kind() == Kind::PREDICATION) {
+        return Node(m_Archive, m_Archive->argument(m_Index, i));
+    }
+    return Node(m_Archive, m_Archive->nodeField(m_Index, 1 + i));
+}
+
+}
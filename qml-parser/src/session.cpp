@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "session.hpp"
+
+#include <algorithm>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+#include "lexer.hpp"
+#include "teardown.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    // Replaces list[begin, end) with make(0), ..., make(count - 1), moving what follows only if as many are put in as taken out.
+    template<typename T, typename Make>
+    void splice(std::vector<T>& list, size_t begin, size_t end, size_t count, const Make& make)
+    {
+        const size_t kept = std::min(end - begin, count);
+        const auto at = list.begin() + static_cast<std::ptrdiff_t>(begin + kept);
+        if (kept < end - begin) {
+            list.erase(at, list.begin() + static_cast<std::ptrdiff_t>(end));
+        }
+        else if (kept < count) {
+            list.insert(at, count - kept, T{});
+        }
+        for (size_t i = 0; i < count; ++i) {
+            list[begin + i] = make(i);
+        }
+    }
+}
+
+/**
+ * @brief Constructs a session over `text`, and parses it.
+ * @param text The formula to start from.
+ * @param entry The rule to parse from (default: equivalence).
+ * @param mappingFunction Function that maps tokens to modal operators (default: alethic logic).
+ */
+ParseSession::ParseSession(std::string_view text, Rule entry, Parser::MappingFunction mappingFunction)
+    : m_Text(text), m_Entry(entry), m_MappingFunction(std::move(mappingFunction)), m_Groups(1), m_Result(std::unexpected(std::string()))
+{
+    m_Lexed.push("EOI", TokenType::EOI);
+    relex(0, 0, m_Text.size());
+    reparse();
+}
+
+/**
+ * @brief Replaces `erased` bytes at `offset` with `inserted`, and parses the result.
+ * @param offset Where the edit starts, in bytes.
+ * @param erased How many bytes it removes.
+ * @param inserted What it puts in their place.
+ * @return The result of parsing the edited text.
+ * @throws std::out_of_range if the range to erase is not within the text.
+ */
+auto ParseSession::edit(size_t offset, size_t erased, std::string_view inserted) -> const Result&
+{
+    if (offset > m_Text.size() || erased > m_Text.size() - offset) {
+        throw std::out_of_range("ParseSession edit is outside the text");
+    }
+
+    m_Text.replace(offset, erased, inserted);
+    relex(offset, erased, inserted.size());
+    reparse();
+
+    return m_Result;
+}
+
+/**
+ * @brief Gives the result of the last parse.
+ */
+auto ParseSession::result() const -> const Result&
+{
+    return m_Result;
+}
+
+/**
+ * @brief Gives the current text.
+ */
+std::string_view ParseSession::text() const
+{
+    return m_Text;
+}
+
+// Where the token at `index` begins in the text. The shift wraps around when it is negative.
+size_t ParseSession::position(size_t index) const
+{
+    return index < m_ShiftFrom ? m_Tokens[index].begin : m_Tokens[index].begin + m_Shift;
+}
+
+/*
+ * Lexing from the start of any token gives the same tokens from there on as lexing the
+ * whole text, and a token only depends on the bytes up to the one after it. So every token
+ * that ends a byte before the edit is kept, lexing resumes at the start of the last of them,
+ * and the old tokens are taken back from the first new one that starts where an old one did,
+ * past the inserted text.
+ */
+void ParseSession::relex(size_t offset, size_t erased, size_t inserted)
+{
+    const auto indices = std::views::iota(size_t{ 0 }, m_Tokens.size());
+    const size_t kept = *std::ranges::partition_point(indices, [&](size_t index) {
+        return position(index) + m_Tokens[index].length < offset;
+    });
+    const size_t first = kept == 0 ? 0 : kept - 1;
+    const size_t restart = first < m_Tokens.size() ? std::min(position(first), offset) : offset;
+
+    // Old positions past the erased range, in the coordinates of the new text.
+    const auto shifted = [&](size_t index) { return position(index) - erased + inserted; };
+
+    size_t resume = m_Tokens.size();
+    m_Fresh.clear();
+
+    const std::string_view text(m_Text);
+    Lexer lexer(text.substr(restart));
+    for (TokenView token = lexer.next(); token.type != TokenType::EOI; token = lexer.next()) {
+        const size_t begin = static_cast<size_t>(token.literal.data() - text.data());
+
+        if (begin >= offset + inserted) {
+            const auto old = std::ranges::lower_bound(indices.begin() + static_cast<std::ptrdiff_t>(first), indices.end(), begin, [&](size_t index, size_t position) {
+                return this->position(index) < offset + erased || shifted(index) < position;
+            });
+            if (old != indices.end() && position(*old) >= offset + erased && shifted(*old) == begin) {
+                resume = *old;
+                break;
+            }
+        }
+
+        m_Fresh.push_back({ begin, token.literal.size(), token.type });
+    }
+
+    // Only the tokens between this edit and the one before change how far they are shifted.
+    if (m_ShiftFrom < first) {
+        for (size_t i = m_ShiftFrom; i < first; ++i) {
+            m_Tokens[i].begin += m_Shift;
+        }
+    }
+    else if (m_ShiftFrom > resume) {
+        for (size_t i = resume; i < m_ShiftFrom; ++i) {
+            m_Tokens[i].begin -= m_Shift;
+        }
+    }
+    m_Shift += inserted - erased;
+    m_ShiftFrom = first + m_Fresh.size();
+
+    m_FreshLexed.clear();
+    for (const Span& token : m_Fresh) {
+        m_FreshLexed.push(text.substr(token.begin, token.length), token.type);
+    }
+
+    splice(m_Tokens, first, resume, m_Fresh.size(), [&](size_t i) { return m_Fresh[i]; });
+    splice(m_Groups, first, resume, m_Fresh.size(), [](size_t) { return Parser::Group{}; });
+    m_Lexed.replace(first, resume, m_FreshLexed);
+
+    forget(first);
+}
+
+/*
+ * Drops what the parser recorded over the tokens from `first` on. The prefixes past it go,
+ * and so do the clauses that reach it. No clause spans a connective outside of every
+ * bracket, so those clauses all begin after the last prefix kept.
+ */
+void ParseSession::forget(size_t first)
+{
+    const auto stale = std::ranges::upper_bound(m_Prefixes, first, {}, &Parser::Prefix::index);
+    m_Prefixes.erase(stale, m_Prefixes.end());
+
+    const size_t start = m_Prefixes.empty() ? 0 : m_Prefixes.back().index;
+    for (size_t i = start; i < first; ++i) {
+        if (Parser::Group& group = m_Groups[i]; group.value.has_value() && i + group.length > first) {
+            group.value.reset();
+        }
+    }
+}
+
+void ParseSession::reparse()
+{
+    Parser parser(std::as_const(m_Lexed), m_MappingFunction);
+    parser.setGroups(&m_Groups);
+    parser.setPrefixes(&m_Prefixes);
+
+    // The nodes of the last result the new one does not share are let go of without recursing.
+    Result result = parser.parse(Parser::entryPointFor(m_Entry));
+    std::swap(m_Result, result);
+    if (result.has_value()) {
+        dismantle(std::move(result).value());
+    }
+}
+
+}
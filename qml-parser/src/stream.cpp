@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "stream.hpp"
+
+namespace iif_sadaf::talk::QMLParser {
+
+Generator<std::expected<QMLExpression::Expression, std::string>> parse_each(std::istream& input, Parser::ParseFunction entryPoint, Parser::MappingFunction mappingFunction)
+{
+    Parser parser(std::move(mappingFunction));
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        std::expected<QMLExpression::Expression, std::string> result;
+        {
+            // Closed before yielding, so that the counters of a formula are never left pending.
+            const detail::StatsScope scope;
+            parser.reset(line);
+            result = parser.parse(entryPoint);
+        }
+        co_yield std::move(result);
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "teardown.hpp"
+
+#include <new>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace iif_sadaf::talk::QMLParser {
+
+namespace {
+    using QMLExpression::Expression;
+
+    // Whether destroying `expression` now would go on to destroy other nodes: it is the last owner of a node with operands.
+    bool isDeep(const Expression& expression)
+    {
+        return std::visit([](const auto& node) {
+            using Node = typename std::decay_t<decltype(node)>::element_type;
+            if constexpr (std::is_same_v<Node, QMLExpression::IdentityNode> || std::is_same_v<Node, QMLExpression::PredicationNode>) {
+                return false;
+            }
+            else {
+                return node != nullptr && node.use_count() == 1;
+            }
+        }, expression);
+    }
+}
+
+void dismantle(Expression&& expression) noexcept
+{
+    Expression current = std::move(expression);
+    if (!isDeep(current)) {
+        return;
+    }
+
+    // Only the second operands of binary nodes wait here; the first is taken at once, so chains of prefixes or left-nested connectives need none.
+    std::vector<Expression> pending;
+    for (;;) {
+        Expression next;
+        bool descend = false;
+        const auto take = [&](Expression& operand) {
+            if (isDeep(operand)) {
+                next = std::move(operand);
+                descend = true;
+            }
+        };
+
+        std::visit([&](const auto& node) {
+            using Node = typename std::decay_t<decltype(node)>::element_type;
+            if constexpr (std::is_same_v<Node, QMLExpression::BinaryNode>) {
+                if (isDeep(node->rhs)) {
+                    try {
+                        pending.push_back(std::move(node->rhs));
+                    }
+                    catch (const std::bad_alloc&) {
+                        // Left in place, to be destroyed along with the node.
+                    }
+                }
+                take(node->lhs);
+            }
+            else if constexpr (std::is_same_v<Node, QMLExpression::UnaryNode> || std::is_same_v<Node, QMLExpression::QuantificationNode>) {
+                take(node->scope);
+            }
+        }, current);
+
+        // The node goes with no operand left that would take others with it.
+        if (descend) {
+            current = std::move(next);
+        }
+        else if (!pending.empty()) {
+            current = std::move(pending.back());
+            pending.pop_back();
+        }
+        else {
+            return;
+        }
+    }
+}
+
+OwnedExpression& OwnedExpression::operator=(const OwnedExpression& other)
+{
+    if (this != &other) {
+        dismantle(std::exchange(m_Expression, other.m_Expression));
+    }
+    return *this;
+}
+
+OwnedExpression& OwnedExpression::operator=(OwnedExpression&& other) noexcept
+{
+    if (this != &other) {
+        dismantle(std::exchange(m_Expression, std::move(other.m_Expression)));
+    }
+    return *this;
+}
+
+OwnedExpression::~OwnedExpression()
+{
+    dismantle(std::move(m_Expression));
+}
+
+QMLExpression::Expression OwnedExpression::release() &&
+{
+    return std::move(m_Expression);
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * The pool of worker threads behind `parse_batch()`, `parse_file()` and `parse_parallel()`.
+ * The workers share the options they are given, `std::function` members included: calling
+ * one through a const reference from several threads at once is safe, so what must be safe
+ * to call concurrently is its target, as the public headers ask of the entry point, the
+ * mapping and the callback.
+ */
+namespace iif_sadaf::talk::QMLParser::detail {
+
+// The number of workers to start for `threads` (0 for one per hardware thread), and no more than `tasks`.
+inline size_t workerCount(unsigned int threads, size_t tasks)
+{
+    const size_t wanted = threads != 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+    return std::min(wanted, tasks);
+}
+
+/*
+ * Runs `work(i)` for every worker i, the first on the calling thread, and rethrows the first
+ * exception any of them threw once all are done. `failed()` is called on the thread of every
+ * worker that throws, so that the others can be told to stop.
+ */
+template<typename Work, typename Failed>
+void spread(size_t workers, const Work& work, const Failed& failed)
+{
+    std::mutex mutex;
+    std::exception_ptr error;
+    const auto guarded = [&](size_t i) {
+        try {
+            work(i);
+        }
+        catch (...) {
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            failed();
+        }
+    };
+
+    {
+        std::vector<std::jthread> pool;
+        pool.reserve(workers - 1);
+        for (size_t i = 1; i < workers; ++i) {
+            pool.emplace_back(guarded, i);
+        }
+        guarded(0);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+template<typename Work>
+void spread(size_t workers, const Work& work)
+{
+    spread(workers, work, [] {});
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "serialize.hpp"
+
+namespace QMLExpression = iif_sadaf::talk::QMLExpression;
+namespace QMLParser = iif_sadaf::talk::QMLParser;
+
+namespace test {
+
+// The formulas the benchmarks run over, one per line.
+inline std::vector<std::string> corpus()
+{
+    std::ifstream file(QMLPARSER_TEST_CORPUS, std::ios::binary);
+    std::vector<std::string> formulas;
+    std::string line;
+    while (std::getline(file, line)) {
+        formulas.push_back(line);
+    }
+    return formulas;
+}
+
+// Spells out a node of an archive, so that two trees can be compared whatever nodes they share.
+inline void describe(QMLParser::ExpressionArchive::Node node, std::string& text)
+{
+    using Kind = QMLParser::ExpressionArchive::Kind;
+    const auto describeChildren = [&](size_t count, std::string_view between) {
+        for (size_t i = 0; i < count; ++i) {
+            text += i == 0 ? "" : between;
+            describe(node.child(i), text);
+        }
+    };
+
+    switch (node.kind()) {
+    case Kind::TERM:
+        text += node.termType() == QMLExpression::Term::Type::VARIABLE ? "v:" : "c:";
+        text += node.name();
+        return;
+    case Kind::UNARY:
+    case Kind::BINARY:
+        text += std::to_string(static_cast<int>(node.op()));
+        text += "(";
+        describeChildren(node.kind() == Kind::UNARY ? 1 : 2, ", ");
+        text += ")";
+        return;
+    case Kind::QUANTIFICATION:
+        text += "Q";
+        text += std::to_string(static_cast<int>(node.quantifier()));
+        text += " ";
+        describeChildren(2, " ");
+        return;
+    case Kind::IDENTITY:
+        describeChildren(2, " = ");
+        return;
+    case Kind::PREDICATION:
+        text += node.name();
+        text += "(";
+        describeChildren(node.arity(), ", ");
+        text += ")";
+        return;
+    }
+}
+
+inline std::string describe(QMLParser::ExpressionArchive::Node node)
+{
+    std::string text;
+    describe(node, text);
+    return text;
+}
+
+inline std::string describe(const QMLExpression::Expression& expression)
+{
+    const std::vector<std::byte> bytes = QMLParser::serialize(std::span(&expression, 1));
+    const auto archive = QMLParser::ExpressionArchive::open(bytes);
+    return archive.has_value() ? describe(archive->root(0)) : "unreadable: " + archive.error();
+}
+
+}
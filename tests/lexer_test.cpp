@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "legacy_lexer.hpp"
+#include "lexer.hpp"
+
+namespace {
+    bool sameTokens(const std::vector<QMLParser::Token>& lhs, const std::vector<QMLParser::Token>& rhs)
+    {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            if (lhs[i].type != rhs[i].type || lhs[i].literal != rhs[i].literal) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Every way of cutting a formula short, and a few bytes no token starts with.
+    std::vector<std::string> variants(const std::string& formula)
+    {
+        std::vector<std::string> result;
+        for (size_t length = 0; length < formula.size(); ++length) {
+            result.push_back(formula.substr(0, length));
+        }
+        result.push_back(formula + " $");
+        result.push_back("\xE2\x88" + formula);
+        return result;
+    }
+}
+
+// The table-driven lexer must reproduce the legacy one exactly, ILLEGAL tokens included.
+int main()
+{
+    const std::vector<std::string> formulas = test::corpus();
+    if (formulas.empty()) {
+        std::cerr << "No formulas to test\n";
+        return 1;
+    }
+
+    size_t failures = 0;
+    for (const std::string& formula : formulas) {
+        for (const std::string& text : variants(formula)) {
+            if (!sameTokens(QMLParser::lex(text), QMLParser::legacy::lex(text))) {
+                std::cerr << "lex() disagrees with the legacy lexer on: " << text << "\n";
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "parser.hpp"
+#include "pool.hpp"
+#include "serialize.hpp"
+
+namespace {
+    // Reads `bytes` back every way an archive allows, and compares with what was written.
+    size_t roundTrip(const std::vector<QMLExpression::Expression>& expressions, const std::vector<std::byte>& bytes)
+    {
+        const auto archive = QMLParser::ExpressionArchive::open(bytes);
+        if (!archive.has_value()) {
+            std::cerr << "An archive does not open: " << archive.error() << "\n";
+            return 1;
+        }
+        if (archive->size() != expressions.size()) {
+            std::cerr << "An archive holds " << archive->size() << " expressions instead of " << expressions.size() << "\n";
+            return 1;
+        }
+
+        size_t failures = 0;
+        const std::vector<QMLExpression::Expression> loaded = archive->expressions();
+        for (size_t i = 0; i < expressions.size(); ++i) {
+            const std::string expected = test::describe(expressions[i]);
+            if (test::describe(archive->root(i)) != expected || test::describe(archive->expression(i)) != expected || test::describe(loaded[i]) != expected) {
+                std::cerr << "Expression " << i << " does not read back as written: " << expected << "\n";
+                ++failures;
+            }
+        }
+
+        // The nodes written once are built once, so writing them again gives the same bytes.
+        if (QMLParser::serialize(loaded) != bytes) {
+            std::cerr << "Writing the expressions read back does not give the same bytes\n";
+            ++failures;
+        }
+        return failures;
+    }
+
+    // A damaged archive is to be rejected, or read without going out of its bytes.
+    size_t damage(const std::vector<std::byte>& bytes)
+    {
+        size_t failures = 0;
+        for (size_t length = 0; length < bytes.size(); length += 1 + length / 8) {
+            const std::vector<std::byte> truncated(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(length));
+            if (QMLParser::ExpressionArchive::open(truncated).has_value()) {
+                std::cerr << "An archive cut short at " << length << " bytes opens\n";
+                ++failures;
+            }
+        }
+
+        std::mt19937 random(1);
+        for (size_t i = 0; i < 2000; ++i) {
+            std::vector<std::byte> corrupt = bytes;
+            corrupt[random() % corrupt.size()] = static_cast<std::byte>(random());
+            if (const auto archive = QMLParser::ExpressionArchive::open(corrupt); archive.has_value()) {
+                for (size_t j = 0; j < archive->size(); j += 17) {
+                    test::describe(archive->root(j));
+                }
+            }
+        }
+        return failures;
+    }
+}
+
+// What serialize() writes must read back, through an ExpressionArchive, as the expressions written.
+int main()
+{
+    std::vector<QMLExpression::Expression> expressions;
+    std::vector<QMLExpression::Expression> pooled;
+    QMLParser::ExpressionPool pool;
+    for (const std::string& formula : test::corpus()) {
+        if (auto expression = QMLParser::parse(formula); expression.has_value()) {
+            expressions.push_back(std::move(expression).value());
+            pooled.push_back(QMLParser::parse(formula, pool).value());
+        }
+    }
+    if (expressions.empty()) {
+        std::cerr << "No formulas to test\n";
+        return 1;
+    }
+
+    const std::vector<std::byte> bytes = QMLParser::serialize(expressions);
+    size_t failures = roundTrip(expressions, bytes);
+    failures += roundTrip(pooled, QMLParser::serialize(pooled));
+    failures += roundTrip({}, QMLParser::serialize({}));
+    failures += damage(bytes);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2024-2025 Ramiro Caso <caso.ramiro@conicet.gov.ar>
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "lexer.hpp"
+#include "session.hpp"
+
+namespace {
+    constexpr std::array<const char*, 24> fragments = {
+        "(", ")", "[", "]", " ", "P(x)", "∧", "→", "↔", "¬", "□", "⋄",
+        "∀x", "∃y", "x", "a", "=", ",", "Q(a, b)", "(P(x) ∨ Q(y))", "1", "_", "∨", "∀",
+    };
+
+    std::string describe(const QMLParser::ParseSession::Result& result)
+    {
+        return result.has_value() ? test::describe(result.value()) : "error: " + result.error();
+    }
+
+    // What a parser finds in the text from scratch.
+    std::string reference(const std::string& text, QMLParser::Rule entry)
+    {
+        const std::vector<QMLParser::TokenView> tokens = QMLParser::lex_view(text);
+        QMLParser::Parser parser(tokens, &QMLParser::mapToAlethicOperator);
+        return describe(parser.parse(QMLParser::Parser::entryPointFor(entry)));
+    }
+
+    bool check(const QMLParser::ParseSession& session, QMLParser::Rule entry)
+    {
+        const std::string text(session.text());
+        if (describe(session.result()) != reference(text, entry)) {
+            std::cerr << "ParseSession disagrees with a fresh parse on: " << text << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    // A chain long enough for the parser to resume past the first connectives.
+    std::string chain(size_t operands)
+    {
+        std::string text;
+        for (size_t i = 0; i < operands; ++i) {
+            text += i == 0 ? "" : " ∧ ";
+            text += i % 3 == 0 ? "(P(x) ∨ □Q(a, b))" : "R(c)";
+        }
+        return text;
+    }
+
+    size_t randomEdits(QMLParser::ParseSession& session, QMLParser::Rule entry, std::mt19937& random, size_t count)
+    {
+        size_t failures = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t size = session.text().size();
+            const size_t offset = size == 0 ? 0 : random() % (size + 1);
+            const size_t erased = offset < size && random() % 3 == 0 ? random() % std::min<size_t>(size - offset + 1, 6) : 0;
+            const std::string inserted = random() % 4 == 0 ? "" : fragments[random() % fragments.size()];
+            session.edit(offset, erased, inserted);
+            failures += check(session, entry) ? 0 : 1;
+        }
+        return failures;
+    }
+}
+
+// Edits at random must leave a session with what parsing the edited text from scratch gives.
+int main()
+{
+    const std::vector<std::string> formulas = test::corpus();
+    if (formulas.empty()) {
+        std::cerr << "No formulas to test\n";
+        return 1;
+    }
+
+    constexpr std::array<QMLParser::Rule, 3> entries = { QMLParser::Rule::EQUIVALENCE, QMLParser::Rule::CLAUSE, QMLParser::Rule::UNARY };
+    std::mt19937 random(42);
+    size_t failures = 0;
+
+    for (size_t i = 0; i < formulas.size(); ++i) {
+        const QMLParser::Rule entry = entries[i % entries.size()];
+        QMLParser::ParseSession session(formulas[i], entry);
+        failures += check(session, entry) ? 0 : 1;
+        failures += randomEdits(session, entry, random, 8);
+    }
+
+    QMLParser::ParseSession session(chain(200));
+    failures += check(session, QMLParser::Rule::EQUIVALENCE) ? 0 : 1;
+    for (size_t at = session.text().find("R(c)"); at != std::string_view::npos; at = session.text().find("R(c)", at + 1)) {
+        session.edit(at + 2, 1, "d");
+        failures += check(session, QMLParser::Rule::EQUIVALENCE) ? 0 : 1;
+    }
+    failures += randomEdits(session, QMLParser::Rule::EQUIVALENCE, random, 200);
+
+    // A bracket taken back whole still counts towards the nesting limit.
+    for (const size_t depth : { QMLParser::Parser::default_nesting_limit - 1, QMLParser::Parser::default_nesting_limit }) {
+        const std::string text = std::string("Q(b) ∧ ").append(depth, '(').append("P(a)").append(depth, ')');
+        QMLParser::ParseSession nested(text);
+        nested.edit(std::string_view("Q(b) ∧ ").size(), 0, "(");
+        nested.edit(nested.text().size(), 0, ")");
+        failures += check(nested, QMLParser::Rule::EQUIVALENCE) ? 0 : 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}